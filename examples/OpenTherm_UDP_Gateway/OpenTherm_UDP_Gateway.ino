@@ -0,0 +1,128 @@
+/*
+OpenTherm UDP Gateway Example
+
+Owns the OpenTherm bus and executes request frames received over UDP, so a
+remote controller can talk to the boiler through this node.
+
+Datagram format (big endian):
+Request:  SEQ(2) COUNT(1) COUNT x REQUEST(4)
+Response: SEQ(2) COUNT(1) COUNT x { RESPONSE(4) STATUS(1) }
+STATUS is OpenThermResponseStatus, NONE for a frame that could not be sent
+(line fault, see getLineStatus()). Up to MAX_BATCH frames are run back to back
+per datagram and answered in one datagram with the same SEQ. A repeated SEQ
+(client retransmission after a lost reply) is answered from the last reply
+without touching the bus again. A batch takes up to COUNT x 0.9 s on the bus
+(800 ms response timeout + 100 ms gap), the client timeout should allow that.
+
+Hardware Connections: see OpenTherm_Demo example.
+*/
+
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include <OpenTherm.h>
+
+using namespace OT;
+
+const char *ssid = "ssid";
+const char *password = "password";
+const unsigned int port = 5600;
+
+const int inPin = 4;
+const int outPin = 5;
+OpenTherm ot(inPin, outPin);
+WiFiUDP udp;
+
+const byte MAX_BATCH = 16;
+byte request[3 + MAX_BATCH * 4];
+byte reply[3 + MAX_BATCH * 5];
+size_t replyLength = 0;
+bool replyValid = false;
+IPAddress clientIp;
+uint16_t clientPort;
+byte batchCount = 0;
+byte batchIndex = 0;
+bool busy = false;
+
+void IRAM_ATTR handleInterrupt() {
+	ot.handleInterrupt();
+}
+
+unsigned long readFrame(const byte *p) {
+	return ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16) | ((unsigned long)p[2] << 8) | p[3];
+}
+
+void writeFrame(byte *p, unsigned long frame) {
+	p[0] = frame >> 24;
+	p[1] = frame >> 16;
+	p[2] = frame >> 8;
+	p[3] = frame;
+}
+
+void sendReply() {
+	udp.beginPacket(clientIp, clientPort);
+	udp.write(reply, replyLength);
+	udp.endPacket();
+}
+
+void storeResponse(unsigned long response, OpenThermResponseStatus status) {
+	byte *p = reply + 3 + batchIndex * 5;
+	writeFrame(p, response);
+	p[4] = status;
+	batchIndex++;
+}
+
+void processResponse(unsigned long response, OpenThermResponseStatus status) {
+	storeResponse(response, status);
+	busy = false;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+	WiFi.begin(ssid, password);
+	while (WiFi.status() != WL_CONNECTED) delay(500);
+	Serial.println(WiFi.localIP());
+	udp.begin(port);
+	ot.begin(handleInterrupt, processResponse);
+}
+
+void loop()
+{
+	ot.process();
+
+	if (batchIndex < batchCount) {
+		if (!busy && ot.isReady()) {
+			busy = ot.sendRequestAync(readFrame(request + 3 + batchIndex * 4));
+			if (!busy) storeResponse(0, OpenThermResponseStatus::NONE); // not sent, don't retry forever
+		}
+		return;
+	}
+	if (batchCount > 0) {
+		replyLength = 3 + batchCount * 5;
+		replyValid = true;
+		batchCount = 0;
+		sendReply();
+	}
+
+	int length = udp.parsePacket();
+	if (length <= 0) return;
+	byte datagram[sizeof(request)];
+	length = udp.read(datagram, sizeof(datagram));
+	if (length < 3 || datagram[2] == 0 || datagram[2] > MAX_BATCH || length != 3 + datagram[2] * 4) return;
+
+	if (replyValid && udp.remoteIP() == clientIp && udp.remotePort() == clientPort &&
+		datagram[0] == reply[0] && datagram[1] == reply[1]) {
+		sendReply(); // retransmitted request, our reply was lost
+		return;
+	}
+
+	memcpy(request, datagram, length);
+	clientIp = udp.remoteIP();
+	clientPort = udp.remotePort();
+	reply[0] = request[0];
+	reply[1] = request[1];
+	reply[2] = request[2];
+	replyValid = false;
+	batchCount = request[2];
+	batchIndex = 0;
+}
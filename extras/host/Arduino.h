@@ -0,0 +1,72 @@
+// Minimal Arduino core mock for the host harnesses in this folder. Pins and
+// time are driven by the harness through simPin, simMicros and simWriteHook,
+// which sim.h defines.
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define B0 0
+#define B1 1
+#define B10 2
+#define B11 3
+#define B000 0
+#define B001 1
+#define B010 2
+#define B011 3
+#define B100 4
+#define B101 5
+#define B110 6
+#define B111 7
+#define B1110 14
+#define B1111 15
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define bitRead(value, bit) (((value) >> (bit)) & 1)
+
+extern int simPin;                        // level read by digitalRead(), HIGH is active
+extern unsigned long simMicros;           // returned by micros(), millis() derives from it
+extern void (*simWriteHook)(int, int);    // called by digitalWrite(), may be NULL
+
+inline void pinMode(int, int) {}
+inline int digitalRead(int) { return simPin; }
+inline void digitalWrite(int pin, int value) { if (simWriteHook) simWriteHook(pin, value); }
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterrupt(int, void (*)(void), int) {}
+inline void detachInterrupt(int) {}
+inline void delay(unsigned long) {}
+inline void delayMicroseconds(unsigned int) {}
+inline unsigned long micros() { return simMicros; }
+inline unsigned long millis() { return simMicros / 1000; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void yield() {}
+
+class Print
+{
+public:
+	virtual size_t write(uint8_t) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size) {
+		for (size_t i = 0; i < size; i++) write(buffer[i]);
+		return size;
+	}
+	virtual int availableForWrite() { return 0; }
+	virtual ~Print() {}
+};
+
+class Stream : public Print {};
+
+#endif // Arduino_h
@@ -0,0 +1,60 @@
+// Compares handleInterrupt() against handleInterrupt(timestamp) when the ISR
+// runs a random delay after each edge. The overload receives the exact edge
+// time, as an input capture unit would latch it.
+#include "sim.h"
+#include <stdio.h>
+#include <random>
+
+using namespace OT;
+
+static bool decode(OpenTherm &ot, uint32_t frame, bool captured, unsigned long maxLatency, std::mt19937 &rng)
+{
+	simMicros += 1000000;
+	simPin = 0;
+	while (!ot.isReady()) {
+		simMicros += 200000;
+		ot.process();
+	}
+	ot.sendRequestAync(0);
+	const unsigned long t0 = simMicros + 20000;
+
+	for (long t = 0; t <= 68 * 500; t += 500) {
+		const int level = frameLevelAt(frame, t);
+		if (level == frameLevelAt(frame, t - 1)) continue;
+		const unsigned long edge = t0 + t;
+		simMicros = (edge + rng() % (maxLatency + 1)) & ~3ul; // 4 us micros() resolution
+		simPin = level;
+		if (captured) ot.handleInterrupt(edge);
+		else ot.handleInterrupt();
+	}
+
+	simMicros = t0 + 36000;
+	simPin = 0;
+	ot.process();
+	for (int i = 0; i < 20 && ot.getLastResponseStatus() == NONE; i++) {
+		simMicros += 100000;
+		ot.process();
+	}
+	return ot.getLastResponseStatus() == SUCCESS;
+}
+
+int main()
+{
+	const int frames = 20000;
+	const unsigned long latencies[] = { 0, 100, 200, 250, 300, 400 };
+	OpenTherm polled(2, 3), captured(4, 5);
+	polled.begin(NULL);
+	captured.begin(NULL);
+	std::mt19937 rng(11);
+	for (size_t l = 0; l < sizeof(latencies) / sizeof(latencies[0]); l++) {
+		int okPolled = 0, okCaptured = 0;
+		for (int i = 0; i < frames; i++) {
+			const uint32_t frame = makeResponse(Tboiler, rng() & 0xffff);
+			okPolled += decode(polled, frame, false, latencies[l], rng);
+			okCaptured += decode(captured, frame, true, latencies[l], rng);
+		}
+		printf("ISR latency 0..%3lu us: micros() error rate=%.2f%% captured error rate=%.2f%%\n", latencies[l],
+			100.0 * (frames - okPolled) / frames, 100.0 * (frames - okCaptured) / frames);
+	}
+	return 0;
+}
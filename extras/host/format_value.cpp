@@ -0,0 +1,43 @@
+// Checks valueToString() for every f8.8 value at 0..4 decimals against a
+// reference rounding, then times it against snprintf("%.2f").
+#include "sim.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+using namespace OT;
+
+int main()
+{
+	char out[32], ref[40];
+	int bad = 0;
+	for (int decimals = 0; decimals <= 4; decimals++) {
+		long long scale = 1;
+		for (int i = 0; i < decimals; i++) scale *= 10;
+		for (unsigned int u = 0; u < 65536; u++) {
+			OpenTherm::valueToString(u, OT_F88, out, sizeof(out), decimals);
+			const long long magnitude = (u & 0x8000) ? 65536 - u : u;
+			const long long q = (magnitude * scale + 128) / 256; // round half up
+			const bool negative = (u & 0x8000) && q;
+			if (decimals) snprintf(ref, sizeof(ref), "%s%lld.%0*lld", negative ? "-" : "", q / scale, decimals, q % scale);
+			else snprintf(ref, sizeof(ref), "%s%lld", negative ? "-" : "", q);
+			if (strcmp(out, ref)) {
+				if (bad++ < 5) printf("value=%04x decimals=%d got %s expected %s\n", u, decimals, out, ref);
+			}
+		}
+	}
+	printf("f8.8 mismatches=%d\n", bad);
+
+	const int n = 10000000;
+	volatile size_t sink = 0;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < n; i++) sink += OpenTherm::valueToString((uint16_t)(i * 7919), OT_F88, out, sizeof(out), 2);
+	std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+	for (int i = 0; i < n; i++) sink += snprintf(out, sizeof(out), "%.2f", (double)OpenTherm::getFloat((uint16_t)(i * 7919)));
+	std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+	const double fixed = std::chrono::duration<double>(t1 - t0).count() * 1e9 / n;
+	const double formatted = std::chrono::duration<double>(t2 - t1).count() * 1e9 / n;
+	(void)sink;
+	printf("valueToString %.1f ns, snprintf %.1f ns, speedup %.1fx\n", fixed, formatted, formatted / fixed);
+	return 0;
+}
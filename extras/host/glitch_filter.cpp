@@ -0,0 +1,80 @@
+// Noise sweep for setGlitchFilter(): response frames with random 20..80 us
+// spikes, Poisson-distributed per frame, decoded with the filter off and on.
+#include "sim.h"
+#include <stdio.h>
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace OT;
+
+static OpenTherm ot(2, 3);
+
+static bool decode(uint32_t frame, double spikesPerFrame, int width, unsigned int filter, std::mt19937 &rng)
+{
+	ot.setGlitchFilter(filter);
+	simMicros += 1000000;
+	simPin = 0;
+	while (!ot.isReady()) {
+		simMicros += 200000;
+		ot.process();
+	}
+	ot.sendRequestAync(0);
+	const unsigned long t0 = simMicros + 20000;
+
+	std::vector<unsigned long> edges;
+	for (long t = 0; t <= 68 * 500; t += 500) {
+		if (frameLevelAt(frame, t) != frameLevelAt(frame, t - 1)) edges.push_back(t0 + t);
+	}
+	std::poisson_distribution<int> spikeCount(spikesPerFrame);
+	std::vector<std::pair<unsigned long, unsigned long> > spikes;
+	for (int n = spikeCount(rng); n > 0; n--) {
+		const unsigned long s = t0 - 500 + rng() % 35000;
+		spikes.push_back(std::make_pair(s, s + width));
+		edges.push_back(s);
+		edges.push_back(s + width);
+	}
+	std::sort(edges.begin(), edges.end());
+
+	for (size_t i = 0; i < edges.size(); i++) {
+		const unsigned long t = edges[i] + 4; // ISR entry latency
+		int level = frameLevelAt(frame, (long)(t - t0));
+		for (size_t j = 0; j < spikes.size(); j++) {
+			if (t >= spikes[j].first && t < spikes[j].second) level = !level;
+		}
+		simMicros = t;
+		simPin = level;
+		ot.handleInterrupt();
+	}
+
+	simMicros = t0 + 36000;
+	simPin = 0;
+	ot.process();
+	for (int i = 0; i < 20 && ot.getLastResponseStatus() == NONE; i++) {
+		simMicros += 100000;
+		ot.process();
+	}
+	return ot.getLastResponseStatus() == SUCCESS;
+}
+
+int main()
+{
+	const int frames = 4000;
+	const double rates[] = { 0.0, 0.5, 1.0, 2.0, 4.0 };
+	const unsigned int filters[] = { 0, 100 };
+	std::mt19937 rng(7);
+	ot.begin(NULL);
+	for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+		for (size_t f = 0; f < 2; f++) {
+			int ok = 0;
+			for (int i = 0; i < frames; i++) {
+				const uint32_t frame = makeResponse(Tboiler, rng() & 0xffff);
+				ok += decode(frame, rates[r], 20 + rng() % 60, filters[f], rng);
+			}
+			printf("spikes/frame=%.1f filter=%3u us frame error rate=%.2f%%\n",
+				rates[r], filters[f], 100.0 * (frames - ok) / frames);
+		}
+	}
+	return 0;
+}
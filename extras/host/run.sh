@@ -0,0 +1,15 @@
+#!/bin/sh
+# Builds and runs every host harness against the library sources.
+# Usage: extras/host/run.sh [harness...]   (default: all)
+set -e
+here=$(cd "$(dirname "$0")" && pwd)
+src="$here/../../src"
+out="${TMPDIR:-/tmp}/opentherm-host"
+mkdir -p "$out"
+names="$*"
+[ -n "$names" ] || names="glitch_filter capture_timestamp single_edge format_value trace_merge"
+for name in $names; do
+	echo "== $name"
+	${CXX:-g++} -std=gnu++11 -O2 -Wall -I"$here" -I"$src" "$here/$name.cpp" "$src"/*.cpp -o "$out/$name"
+	"$out/$name"
+done
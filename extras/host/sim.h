@@ -0,0 +1,31 @@
+// Shared bus simulation for the host harnesses, include from exactly one
+// translation unit per harness.
+#ifndef sim_h
+#define sim_h
+
+#include <OpenTherm.h>
+
+int simPin;
+unsigned long simMicros;
+void (*simWriteHook)(int, int);
+
+// Line level (1 = active) of a frame t us after its start bit began.
+inline int frameLevelAt(uint32_t frame, long t)
+{
+	if (t < 0) return 0;
+	const long half = t / 500;
+	if (half >= 68) return 0;
+	const int bit = half / 2;
+	const int high = (bit == 0 || bit == 33) ? 1 : (frame >> (32 - bit)) & 1;
+	return (half % 2 == 0) ? high : !high;
+}
+
+// Slave response with the given data ID and value, parity set.
+inline uint32_t makeResponse(OT::OpenThermMessageID id, uint16_t value)
+{
+	uint32_t frame = (4ul << 28) | ((uint32_t)id << 16) | value;
+	if (OT::OpenTherm::parity(frame)) frame |= 0x80000000;
+	return frame;
+}
+
+#endif // sim_h
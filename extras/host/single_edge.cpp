@@ -0,0 +1,72 @@
+// Decodes the same random response frames with the default CHANGE decoder
+// and with setSingleEdgeDecoding(true), with +-30 us edge jitter.
+#include "sim.h"
+#include <stdio.h>
+#include <random>
+
+using namespace OT;
+
+static unsigned long lastResponse;
+
+static void responseCallback(unsigned long response, OpenThermResponseStatus)
+{
+	lastResponse = response;
+}
+
+static OpenThermResponseStatus decode(OpenTherm &ot, uint32_t frame, bool singleEdge, std::mt19937 &rng, long &isrCount)
+{
+	simMicros += 2000000;
+	simPin = 0;
+	while (!ot.isReady()) {
+		simMicros += 50000;
+		ot.process();
+	}
+	ot.sendRequestAync(0);
+	const unsigned long t0 = simMicros + 30000;
+
+	for (long t = 0; t <= 68 * 500; t += 500) {
+		const int level = frameLevelAt(frame, t);
+		if (level == frameLevelAt(frame, t - 1)) continue;
+		if (singleEdge && !level) continue; // RISING only sees idle to active edges
+		simMicros = t0 + t + rng() % 61 - 30;
+		simPin = level;
+		ot.handleInterrupt();
+		isrCount++;
+	}
+
+	simMicros = t0 + 40000;
+	simPin = 0;
+	ot.process();
+	while (ot.getLastResponseStatus() == NONE) {
+		simMicros += 100000;
+		ot.process();
+	}
+	return ot.getLastResponseStatus();
+}
+
+int main()
+{
+	const int frames = 100000;
+	OpenTherm both(2, 3), single(4, 5);
+	single.setSingleEdgeDecoding(true);
+	both.begin(NULL, responseCallback);
+	single.begin(NULL, responseCallback);
+	std::mt19937 rng(5);
+	int mismatches = 0;
+	long isrBoth = 0, isrSingle = 0;
+	for (int i = 0; i < frames; i++) {
+		uint32_t frame = (rng() & 0x0FFFFFFF) | (4ul << 28); // READ_ACK, random spare bits, ID and value
+		if (OpenTherm::parity(frame)) frame |= 0x80000000;
+		const OpenThermResponseStatus a = decode(both, frame, false, rng, isrBoth);
+		const unsigned long ra = lastResponse;
+		const OpenThermResponseStatus b = decode(single, frame, true, rng, isrSingle);
+		const unsigned long rb = lastResponse;
+		if (a != b || ra != rb || ra != frame) {
+			if (mismatches++ < 5) printf("frame=%08lx both=%08lx(%d) single=%08lx(%d)\n",
+				(unsigned long)frame, ra, a, rb, b);
+		}
+	}
+	printf("mismatches=%d ISR/frame both-edge=%.1f single-edge=%.1f\n",
+		mismatches, (double)isrBoth / frames, (double)isrSingle / frames);
+	return 0;
+}
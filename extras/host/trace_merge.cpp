@@ -0,0 +1,53 @@
+// Merges 8..64 trace rings with OpenThermTraceMerge: about 10 frames/s per
+// bus, channel 0 idle every other 5 s. Reports ordering, loss and cost.
+#include "sim.h"
+#include <OpenThermTraceMerge.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+using namespace OT;
+
+int main()
+{
+	const int channelCounts[] = { 8, 16, 32, 64 };
+	for (size_t c = 0; c < sizeof(channelCounts) / sizeof(channelCounts[0]); c++) {
+		const int n = channelCounts[c];
+		srand(n);
+		std::vector<std::vector<OpenThermTraceRecord> > storage(n, std::vector<OpenThermTraceRecord>(256));
+		std::vector<OpenThermTrace *> traces;
+		std::vector<OpenThermMergeChannel> channels(n);
+		for (int i = 0; i < n; i++) {
+			traces.push_back(new OpenThermTrace(storage[i].data(), 256));
+			channels[i].trace = traces[i];
+		}
+		OpenThermTraceMerge merge(channels.data(), n, 200);
+
+		unsigned long last = 0, maxLag = 0;
+		long in = 0, out = 0, disorder = 0;
+		double ns = 0;
+		for (unsigned long now = 1; now <= 200000; now++) { // 1 ms steps
+			for (int i = 0; i < n; i++) {
+				if (rand() % 100 == 0 && !(i == 0 && (now / 5000) % 2)) {
+					traces[i]->push(now, i, 0, SUCCESS);
+					in++;
+				}
+			}
+			std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+			OpenThermTraceRecord record;
+			byte channel;
+			while (merge.read(record, channel, now)) {
+				if ((long)(record.timestamp - last) < 0) disorder++;
+				last = record.timestamp;
+				if (now - record.timestamp > maxLag) maxLag = now - record.timestamp;
+				out++;
+			}
+			ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+		}
+		printf("channels=%d in=%ld out=%ld out of order=%ld lost=%u max lag=%lu ms, %.0f ns/record\n",
+			n, in, out, disorder, merge.getLostCount(), maxLag, ns / out);
+		for (int i = 0; i < n; i++) delete traces[i];
+	}
+	return 0;
+}
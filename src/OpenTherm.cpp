@@ -4,8 +4,27 @@ Copyright 2018, Ihor Melnyk
 */
 
 #include "OpenTherm.h"
+#include "OpenThermTrace.h"
 namespace OT {
 
+// Protocol deadlines (microseconds). A single instance has at most one pending
+// deadline at a time, measured from responseTimestamp, so process() checks it in O(1).
+static const unsigned long OT_RESPONSE_TIMEOUT_US = 800000; // request end to response stop bit
+static const unsigned long OT_FRAME_GAP_US = 100000;        // response to next request
+static const unsigned long OT_FRAME_IDLE_US = 3000;         // no mid-bit edge for this long ends a partial frame
+static const unsigned long OT_BIT_WINDOW_US = 750;          // 3/4 bit, separates mid-bit from bit-boundary edges
+static const unsigned int OT_LINE_STUCK_US = 1100;          // longer than the longest active level of a frame (2 half-bits)
+static const byte OT_LINE_FAULT_COUNT = 3;                  // consecutive failed transactions before a fault is reported
+static const unsigned long OT_OVERLOAD_HOLD_US = 1000000;   // overload ends this long after the last late event
+static const unsigned long OT_LINE_PROBE_US = 5000000;      // one request per interval while the line is open or silent
+static const unsigned int OT_HALF_BIT_US = 500;
+static const byte OT_FRAME_HALF_BITS = 68;                  // start bit, 32 frame bits, stop bit
+static const unsigned long OT_LOOPBACK_TIMEOUT_US = 200;    // no echo within this time means no loopback
+static const byte OT_CALIBRATION_SAMPLES = 8;
+static const int OT_MAX_EDGE_SKEW_US = 100;
+static const byte OT_MAX_DECIMALS = 4;                      // f8.8 resolution is 0.0039
+static const uint32_t OT_CHECKPOINT_MAGIC = 0x4F544350;     // "OTCP"
+
 OpenTherm::OpenTherm(int inPin, int outPin):
 	inPin(inPin),
 	outPin(outPin),	
@@ -13,8 +32,54 @@ OpenTherm::OpenTherm(int inPin, int outPin):
 	response(0),
 	responseStatus(OpenThermResponseStatus::NONE),
 	responseTimestamp(0),
+	responseBitIndex(0),
+	request(0),
+	txEchoEdgeCount(0),
+	txEchoSuppression(false),
+	singleEdgeDecoding(false),
+	warmStart(false),
+	repeatTarget(NULL),
+	listenOnly(false),
+	pendingRequest(0),
+	requestPending(false),
+	valueTable(NULL),
+	valueTableSize(0),
+	trace(NULL),
+	batchRequests(NULL),
+	batchResponses(NULL),
+	batchStatuses(NULL),
+	batchCount(0),
+	batchIndex(0),
+	batchStopMask(0),
+	batchInFlight(false),
+	maxLateness(0),
+	processLateness(0),
+	overloaded(false),
+	overloadTimestamp(0),
+	lastProcessTimestamp(0),
+	shedCount(0),
+	txEchoSeen(false),
+	lineStatus(OpenThermLineStatus::LINE_OK),
+	noResponseCount(0),
+	lastSendTimestamp(0),
+	lineFaultBackoff(false),
+	invalidResponseCount(0),
+	propagationDelay(0),
+	edgeSkew(0),
+	skewCompensation(0),
+	glitchFilterWidth(0),
+	lastEdgeTimestamp(0),
+	previousEdgeTimestamp(0),
+	lastEdgeState(0),
+	edgeStatus(OpenThermStatus::NOT_INITIALIZED),
+	preEdgeStatus(OpenThermStatus::NOT_INITIALIZED),
+	preEdgeResponse(0),
+	preEdgeTimestamp(0),
+	preEdgeBitIndex(0),
 	handleInterruptCallback(NULL),
-	processResponseCallback(NULL)
+	processResponseCallback(NULL),
+	processTransactionCallback(NULL),
+	processBatchCallback(NULL)
 {
 }
 
@@ -22,9 +87,10 @@ void OpenTherm::begin(void(*handleInterruptCallback)(void), void(*processRespons
 {
 	pinMode(inPin, INPUT);
 	pinMode(outPin, OUTPUT);
+	resetEdgeFilter(micros());
 	if (handleInterruptCallback != NULL) {
 		this->handleInterruptCallback = handleInterruptCallback;
-		attachInterrupt(digitalPinToInterrupt(inPin), handleInterruptCallback, CHANGE);		
+		attachInterrupt(digitalPinToInterrupt(inPin), handleInterruptCallback, singleEdgeDecoding ? RISING : CHANGE);		
 	}
 	activateBoiler();
 	status = OpenThermStatus::READY;
@@ -55,14 +121,87 @@ void OpenTherm::setIdleState() {
 
 void OpenTherm::activateBoiler() {
 	setIdleState();
-	delay(1000);
+	if (!warmStart) delay(1000);
+}
+
+void OpenTherm::sendHalfBit(bool active, int skew) {
+	if (active) {
+		setActiveState();
+		delayMicroseconds(OT_HALF_BIT_US - skew);
+	}
+	else {
+		setIdleState();
+		delayMicroseconds(OT_HALF_BIT_US + skew);
+	}
 }
 
-void OpenTherm::sendBit(bool high) {
-	if (high) setActiveState(); else setIdleState();
-	delayMicroseconds(500);
-	if (high) setIdleState(); else setActiveState();
-	delayMicroseconds(500);
+bool OpenTherm::isHalfBitActive(unsigned long frame, byte index)
+{
+	if (index >= OT_FRAME_HALF_BITS) return false;
+	const byte bit = index >> 1; // 0 is the start bit, 33 the stop bit
+	const bool high = (bit == 0 || bit == 33) ? true : bitRead(frame, 32 - bit);
+	return (index & 1) ? !high : high;
+}
+
+bool OpenTherm::waitState(int state, unsigned long &elapsed)
+{
+	const unsigned long start = micros();
+	do {
+		elapsed = micros() - start;
+		if (readState() == state) return true;
+	} while (elapsed < OT_LOOPBACK_TIMEOUT_US);
+	return false;
+}
+
+// Drives short pulses onto the line and times their echo. An active level
+// that is seen late by riseDelay and released late by fallDelay is observed
+// edgeSkew = fallDelay - riseDelay too long. That is the sum of the TX and the
+// RX stage skew, which a loopback cannot separate, so only the share set by
+// setSkewCompensation() is taken off the transmitted active half-bits.
+bool OpenTherm::calibrateLoopback()
+{
+	noInterrupts();
+	const bool ready = isReady();
+	interrupts();
+	if (!ready) return false;
+
+	status = OpenThermStatus::REQUEST_SENDING; // echo edges are ignored by handleInterrupt()
+	unsigned long riseSum = 0, fallSum = 0;
+	bool echo = true;
+	for (byte i = 0; i < OT_CALIBRATION_SAMPLES && echo; i++) {
+		unsigned long rise, fall;
+		setActiveState();
+		echo = waitState(HIGH, rise);
+		setIdleState();
+		echo = waitState(LOW, fall) && echo;
+		riseSum += rise;
+		fallSum += fall;
+		delayMicroseconds(OT_HALF_BIT_US);
+	}
+	status = OpenThermStatus::READY;
+	if (!echo) return false;
+
+	int skew = (long)(fallSum - riseSum) / OT_CALIBRATION_SAMPLES;
+	if (skew > OT_MAX_EDGE_SKEW_US) skew = OT_MAX_EDGE_SKEW_US;
+	if (skew < -OT_MAX_EDGE_SKEW_US) skew = -OT_MAX_EDGE_SKEW_US;
+	edgeSkew = skew;
+	propagationDelay = (riseSum + fallSum) / (2 * OT_CALIBRATION_SAMPLES);
+	return true;
+}
+
+unsigned int OpenTherm::getPropagationDelay()
+{
+	return propagationDelay;
+}
+
+int OpenTherm::getEdgeSkew()
+{
+	return edgeSkew;
+}
+
+void OpenTherm::setSkewCompensation(byte txSharePercent)
+{
+	skewCompensation = txSharePercent > 100 ? 100 : txSharePercent;
 }
 
 bool OpenTherm::sendRequestAync(unsigned long request)
@@ -72,25 +211,104 @@ bool OpenTherm::sendRequestAync(unsigned long request)
 	const bool ready = isReady();
 	interrupts();
 
-	if (!ready)
-	  return false;
+	// a refused request must not leave the previous result in getLastResponseStatus()
+	if (!ready || listenOnly) {
+		responseStatus = OpenThermResponseStatus::NONE;
+		return false;
+	}
+
+	if (isLineStuckActive()) {
+		lineStatus = OpenThermLineStatus::LINE_STUCK_ACTIVE;
+		responseStatus = OpenThermResponseStatus::NONE;
+		return false;
+	}
+	if (lineStatus == OpenThermLineStatus::LINE_STUCK_ACTIVE) {
+		lineStatus = OpenThermLineStatus::LINE_OK;
+	}
+	// with back-off, an open line or a silent boiler only gets a probe now and
+	// then, its result clears the fault
+	const unsigned long now = micros();
+	if (lineFaultBackoff && (lineStatus == OpenThermLineStatus::LINE_STUCK_IDLE || lineStatus == OpenThermLineStatus::LINE_NO_RESPONSE)
+		&& (now - lastSendTimestamp) < OT_LINE_PROBE_US) {
+		responseStatus = OpenThermResponseStatus::NONE;
+		return false;
+	}
+	lastSendTimestamp = now;
 
 	status = OpenThermStatus::REQUEST_SENDING;
+	this->request = request;
 	response = 0;
 	responseStatus = OpenThermResponseStatus::NONE;
+	txEchoEdgeCount = 0;
 
-	sendBit(HIGH); //start bit
-	for (int i = 31; i >= 0; i--) {
-		sendBit(bitRead(request, i));
+	const bool detach = txEchoSuppression && handleInterruptCallback != NULL;
+	if (detach) detachInterrupt(digitalPinToInterrupt(inPin));
+	const int skew = (long)edgeSkew * skewCompensation / 100;
+	for (byte i = 0; i < OT_FRAME_HALF_BITS; i++) {
+		sendHalfBit(isHalfBitActive(request, i), skew);
 	}
-	sendBit(HIGH); //stop bit  
 	setIdleState();
+	// a stale edge latched while detached fires here and is ignored as REQUEST_SENDING
+	if (detach) {
+		attachInterrupt(digitalPinToInterrupt(inPin), handleInterruptCallback, singleEdgeDecoding ? RISING : CHANGE);
+	}
+	else if (txEchoEdgeCount > 0) {
+		txEchoSeen = true;
+		if (lineStatus == OpenThermLineStatus::LINE_STUCK_IDLE) lineStatus = OpenThermLineStatus::LINE_OK;
+	}
+	else if (txEchoSeen && handleInterruptCallback != NULL) {
+		lineStatus = OpenThermLineStatus::LINE_STUCK_IDLE;
+	}
 
 	status = OpenThermStatus::RESPONSE_WAITING;
 	responseTimestamp = micros();	
+	resetEdgeFilter(responseTimestamp);
 	return true;
 }
 
+// The bus must be idle before we send. A frame never stays active for more
+// than two half-bits, so an input still active after OT_LINE_STUCK_US is stuck.
+bool OpenTherm::isLineStuckActive()
+{
+	if (readState() == LOW) return false;
+	delayMicroseconds(OT_LINE_STUCK_US);
+	return readState() == HIGH;
+}
+
+void OpenTherm::updateLineStatus(OpenThermStatus st)
+{
+	if (responseStatus == OpenThermResponseStatus::SUCCESS) {
+		noResponseCount = 0;
+		invalidResponseCount = 0;
+		if (lineStatus != OpenThermLineStatus::LINE_STUCK_IDLE) lineStatus = OpenThermLineStatus::LINE_OK;
+	}
+	else if (responseStatus == OpenThermResponseStatus::TIMEOUT && st == OpenThermStatus::RESPONSE_WAITING) {
+		invalidResponseCount = 0;
+		if (noResponseCount < OT_LINE_FAULT_COUNT) noResponseCount++;
+		if (noResponseCount == OT_LINE_FAULT_COUNT && lineStatus == OpenThermLineStatus::LINE_OK) {
+			lineStatus = OpenThermLineStatus::LINE_NO_RESPONSE;
+		}
+	}
+	else {
+		noResponseCount = 0;
+		if (lineStatus == OpenThermLineStatus::LINE_NO_RESPONSE) lineStatus = OpenThermLineStatus::LINE_OK; // the boiler answers again
+		if (invalidResponseCount < OT_LINE_FAULT_COUNT) invalidResponseCount++;
+		if (invalidResponseCount == OT_LINE_FAULT_COUNT && lineStatus == OpenThermLineStatus::LINE_OK) {
+			lineStatus = OpenThermLineStatus::LINE_NOISY;
+		}
+	}
+}
+
+void OpenTherm::setLineFaultBackoff(bool enable)
+{
+	lineFaultBackoff = enable;
+}
+
+OpenThermLineStatus OpenTherm::getLineStatus()
+{
+	return lineStatus;
+}
+
 unsigned long OpenTherm::sendRequest(unsigned long request)
 {	
 	if (!sendRequestAync(request)) return 0;
@@ -101,16 +319,261 @@ unsigned long OpenTherm::sendRequest(unsigned long request)
 	return response;
 }
 
+bool OpenTherm::sendRequestBatchAsync(const unsigned long *requests, unsigned long *responses, OpenThermResponseStatus *statuses, byte count,
+	void(*processBatchCallback)(byte), byte stopMask)
+{
+	if (batchRequests != NULL || count == 0 || listenOnly || status == OpenThermStatus::NOT_INITIALIZED) return false;
+
+	// process() sends the first request once the bus is ready, so a batch can be
+	// queued during the frame gap or from a completion callback
+	batchRequests = requests;
+	batchResponses = responses;
+	batchStatuses = statuses;
+	batchCount = count;
+	batchIndex = 0;
+	batchStopMask = stopMask;
+	this->processBatchCallback = processBatchCallback;
+	lastProcessTimestamp = micros(); // pace is measured from here
+	return true;
+}
+
+byte OpenTherm::sendRequestBatch(const unsigned long *requests, unsigned long *responses, OpenThermResponseStatus *statuses, byte count, byte stopMask)
+{
+	if (!sendRequestBatchAsync(requests, responses, statuses, count, NULL, stopMask)) return 0;
+	while (batchRequests != NULL) {
+		process();
+		yield();
+	}
+	return batchIndex;
+}
+
+// Sends the next batch request, shedding low priority reads first while overloaded.
+// Returns false if nothing was sent.
+bool OpenTherm::sendBatchRequest()
+{
+	while (overloaded && getMessageType(batchRequests[batchIndex]) == READ_DATA && getDataID(batchRequests[batchIndex]) != Status) {
+		batchResponses[batchIndex] = 0;
+		batchStatuses[batchIndex] = OpenThermResponseStatus::NONE;
+		shedCount++;
+		if (++batchIndex >= batchCount) return false;
+	}
+	batchInFlight = sendRequestAync(batchRequests[batchIndex]);
+	return batchInFlight;
+}
+
+void OpenTherm::completeBatchRequest()
+{
+	batchInFlight = false;
+	batchResponses[batchIndex] = response;
+	batchStatuses[batchIndex] = responseStatus;
+	batchIndex++;
+	if (batchIndex >= batchCount || (batchStopMask & (1 << responseStatus))) {
+		finishBatch();
+	}
+}
+
+void OpenTherm::finishBatch()
+{
+	batchRequests = NULL;
+	if (processBatchCallback != NULL) {
+		processBatchCallback(batchIndex);
+	}
+}
+
+void OpenTherm::setLoadShedding(unsigned long maxLateness)
+{
+	this->maxLateness = maxLateness;
+	if (maxLateness == 0) overloaded = false;
+}
+
+// Overload ends once process() is back within half the limit, or when no late
+// event was seen for OT_OVERLOAD_HOLD_US.
+void OpenTherm::updateLoad(unsigned long lateness, unsigned long now)
+{
+	processLateness = lateness;
+	if (maxLateness == 0) return;
+	overloaded = lateness > (overloaded ? maxLateness / 2 : maxLateness);
+	if (overloaded) overloadTimestamp = now;
+}
+
+void OpenTherm::expireOverload(unsigned long now)
+{
+	if (overloaded && (now - overloadTimestamp) > OT_OVERLOAD_HOLD_US) overloaded = false;
+}
+
+unsigned long OpenTherm::getProcessLateness()
+{
+	return processLateness;
+}
+
+bool OpenTherm::isOverloaded()
+{
+	expireOverload(micros());
+	return overloaded;
+}
+
+byte OpenTherm::getQueueDepth()
+{
+	return batchRequests != NULL ? batchCount - batchIndex : 0;
+}
+
+unsigned int OpenTherm::getShedCount()
+{
+	return shedCount;
+}
+
 OpenThermResponseStatus OpenTherm::getLastResponseStatus()
 {
 	return responseStatus;
 }
 
+void OpenTherm::setGlitchFilter(unsigned int minPulseWidth)
+{
+	glitchFilterWidth = minPulseWidth;
+}
+
+// Returns true if the edge at newTs must be ignored. An edge that leaves the pin
+// at the level it already had is a pulse that ended before the ISR sampled it.
+// An edge closer than glitchFilterWidth to the previous one ends a spike, so the
+// decoder step taken on the spike's first edge is rolled back.
+bool OpenTherm::filterGlitch(unsigned long newTs)
+{
+	const byte state = readState();
+	if (state == lastEdgeState) return true;
+	lastEdgeState = state;
+
+	if ((newTs - lastEdgeTimestamp) < glitchFilterWidth) {
+		if (status == edgeStatus) {
+			status = preEdgeStatus;
+			response = preEdgeResponse;
+			responseTimestamp = preEdgeTimestamp;
+			responseBitIndex = preEdgeBitIndex;
+		}
+		lastEdgeTimestamp = previousEdgeTimestamp;
+		edgeStatus = OpenThermStatus::NOT_INITIALIZED;
+		return true;
+	}
+
+	previousEdgeTimestamp = lastEdgeTimestamp;
+	lastEdgeTimestamp = newTs;
+	preEdgeStatus = status;
+	preEdgeResponse = response;
+	preEdgeTimestamp = responseTimestamp;
+	preEdgeBitIndex = responseBitIndex;
+	return false;
+}
+
+void OpenTherm::setTxEchoSuppression(bool enable)
+{
+	txEchoSuppression = enable;
+}
+
+byte OpenTherm::getTxEchoEdgeCount()
+{
+	return txEchoEdgeCount;
+}
+
+bool OpenTherm::isTxEchoValid()
+{
+	// every bit has a mid-bit edge, equal neighbours add a bit-boundary edge,
+	// plus the idle to active edge of the start bit
+	byte equalPairs = bitRead(request, 31) + bitRead(request, 0) + 31;
+	for (unsigned long diff = (request ^ (request >> 1)) & 0x7FFFFFFF; diff > 0; diff &= diff - 1) {
+		equalPairs--;
+	}
+	const byte edges = 1 + 34 + equalPairs;
+	// edges alternate from idle to active and back, single edge mode sees half
+	return txEchoEdgeCount == (singleEdgeDecoding ? edges / 2 : edges);
+}
+
+bool OpenTherm::isEdgeExpected()
+{
+	if (isReady()) return false;
+	if (status == OpenThermStatus::REQUEST_SENDING) {
+		txEchoEdgeCount++;
+		return false;
+	}
+	return true;
+}
+
+bool OpenTherm::setRepeater(OpenTherm *target)
+{
+	if (singleEdgeDecoding && target != NULL) return false;
+	repeatTarget = target;
+	return true;
+}
+
+// Cut-through forwarding: the line level is copied to the other side as soon
+// as the edge interrupt runs, so the added delay is the ISR latency, not a frame.
+// A frame is fully forwarded before it is decoded, it cannot be altered here.
+void OpenTherm::repeatEdge()
+{
+	OpenTherm *target = repeatTarget;
+	if (target == NULL || singleEdgeDecoding) return; // the release edge is never seen
+	if (readState() == HIGH) target->setActiveState(); else target->setIdleState();
+}
+
 void OpenTherm::handleInterrupt()
 {	
-	if (isReady()) return;	
+	repeatEdge();
+	if (isEdgeExpected()) decodeEdge(micros());
+}
+
+void OpenTherm::handleInterrupt(unsigned long timestamp)
+{
+	repeatEdge();
+	if (isEdgeExpected()) decodeEdge(timestamp);
+}
+
+void OpenTherm::setSingleEdgeDecoding(bool enable)
+{
+	singleEdgeDecoding = enable;
+}
+
+// Manchester decoding from idle to active edges only. Such an edge is either at
+// a bit boundary (between two 1 bits) or in the middle of a 0 bit, and the next
+// one follows 2, 3 or 4 half-bits later. Counting half-bits from the start bit
+// (responseBitIndex) places every edge, so each odd position marks a 0 bit and
+// all other bits are 1. The frame is complete at position 65 or 66.
+void OpenTherm::decodeActiveEdge(unsigned long newTs)
+{
+	if (status == OpenThermStatus::RESPONSE_WAITING) {
+		status = OpenThermStatus::RESPONSE_RECEIVING;
+		response = 0xFFFFFFFF;
+		responseBitIndex = 0;
+	}
+	else if (status == OpenThermStatus::RESPONSE_RECEIVING) {
+		const unsigned long halfBits = (newTs - responseTimestamp + OT_HALF_BIT_US / 2) / OT_HALF_BIT_US;
+		if (halfBits < 2 || halfBits > 4) {
+			status = OpenThermStatus::RESPONSE_INVALID;
+		}
+		else {
+			responseBitIndex += halfBits;
+			const byte bit = responseBitIndex >> 1;
+			if (responseBitIndex & 1) {
+				if (bit >= 1 && bit <= 32) response &= ~(1ul << (32 - bit));
+				else status = OpenThermStatus::RESPONSE_INVALID; //start and stop bits are 1
+			}
+			if (status == OpenThermStatus::RESPONSE_RECEIVING && responseBitIndex >= 65) {
+				status = OpenThermStatus::RESPONSE_READY;
+			}
+		}
+	}
+	else {
+		return;
+	}
+	responseTimestamp = newTs;
+}
+
+void OpenTherm::decodeEdge(unsigned long newTs)
+{
+	if (singleEdgeDecoding) {
+		// a glitch that is already over reads back as idle
+		if (glitchFilterWidth == 0 || readState() == HIGH) decodeActiveEdge(newTs);
+		return;
+	}
+	if (glitchFilterWidth > 0 && filterGlitch(newTs)) return;
 
-	unsigned long newTs = micros();
 	if (status == OpenThermStatus::RESPONSE_WAITING) {
 		if (readState() == HIGH) {
 			status = OpenThermStatus::RESPONSE_START_BIT;
@@ -122,7 +585,7 @@ void OpenTherm::handleInterrupt()
 		}
 	}
 	else if (status == OpenThermStatus::RESPONSE_START_BIT) {
-		if ((newTs - responseTimestamp < 750) && readState() == LOW) {
+		if ((newTs - responseTimestamp < OT_BIT_WINDOW_US) && readState() == LOW) {
 			status = OpenThermStatus::RESPONSE_RECEIVING;
 			responseTimestamp = newTs;
 			responseBitIndex = 0;
@@ -133,7 +596,7 @@ void OpenTherm::handleInterrupt()
 		}
 	}
 	else if (status == OpenThermStatus::RESPONSE_RECEIVING) {
-		if ((newTs - responseTimestamp) > 750) {
+		if ((newTs - responseTimestamp) > OT_BIT_WINDOW_US) {
 			if (responseBitIndex < 32) {
 				response = (response << 1) | !readState();
 				responseTimestamp = newTs;
@@ -145,6 +608,7 @@ void OpenTherm::handleInterrupt()
 			}
 		}
 	}
+	edgeStatus = status;
 }
 
 void OpenTherm::process()
@@ -154,45 +618,163 @@ void OpenTherm::process()
 	unsigned long ts = responseTimestamp;
 	interrupts();	
 
-	if (st == OpenThermStatus::READY) return;
 	unsigned long newTs = micros();
-	if (st != OpenThermStatus::NOT_INITIALIZED && (newTs - ts) > 800000) {
+	const unsigned long sinceLastCall = newTs - lastProcessTimestamp;
+	lastProcessTimestamp = newTs;
+	if (st == OpenThermStatus::READY) {
+		if (batchRequests != NULL) {
+			// shed on the loop's current pace, an old late event only counts for a while
+			if (maxLateness != 0 && sinceLastCall > maxLateness) updateLoad(sinceLastCall, newTs);
+			else expireOverload(newTs);
+			if (!sendBatchRequest()) finishBatch();
+		}
+		return;
+	}
+	if (listenOnly) {
+		processListening(st, ts, newTs);
+		return;
+	}
+	// a late process() must not turn a received frame or the gap into a timeout
+	const bool waiting = st == OpenThermStatus::REQUEST_SENDING || st == OpenThermStatus::RESPONSE_WAITING
+		|| st == OpenThermStatus::RESPONSE_START_BIT || st == OpenThermStatus::RESPONSE_RECEIVING;
+	if (waiting && (newTs - ts) > OT_RESPONSE_TIMEOUT_US) {
+		updateLoad(newTs - ts - OT_RESPONSE_TIMEOUT_US, newTs);
 		responseStatus = OpenThermResponseStatus::TIMEOUT;
+		updateLineStatus(st);
+		traceTransaction(request, response, responseStatus);
 		if (processResponseCallback != NULL) {
 			processResponseCallback(response, responseStatus);
 		}
 		status = OpenThermStatus::READY;		
+		if (batchInFlight) completeBatchRequest();
 	}	
 	else if (st == OpenThermStatus::RESPONSE_INVALID) {		
+		updateLoad(newTs - ts, newTs);
 		responseStatus = OpenThermResponseStatus::INVALID;
+		updateLineStatus(st);
+		traceTransaction(request, response, responseStatus);
 		if (processResponseCallback != NULL) {
 			processResponseCallback(response, responseStatus);
 		}
 		status = OpenThermStatus::DELAY;		
+		if (batchInFlight) completeBatchRequest();
 	}
 	else if (st == OpenThermStatus::RESPONSE_READY) {		
+		updateLoad(newTs - ts, newTs);
 		responseStatus = isValidResponse(response) ? OpenThermResponseStatus::SUCCESS : OpenThermResponseStatus::INVALID;
+		updateLineStatus(st);
+		traceTransaction(request, response, responseStatus);
 		if (processResponseCallback != NULL) {
 			processResponseCallback(response, responseStatus);
 		}
 		status = OpenThermStatus::DELAY;		
+		if (batchInFlight) completeBatchRequest();
 	}
 	else if (st == OpenThermStatus::DELAY) {
-		if ((newTs - ts) > 100000) {
+		if ((newTs - ts) > OT_FRAME_GAP_US) {
+			updateLoad(newTs - ts - OT_FRAME_GAP_US, newTs);
 			status = OpenThermStatus::READY;
 		}
 	}	
 }
 
-bool OpenTherm::parity(unsigned long frame) //odd parity
+bool OpenTherm::startListening(void(*processTransactionCallback)(unsigned long, unsigned long))
 {
-	byte p = 0;
-	while (frame > 0)
-	{
-		if (frame & 1) p++;
-		frame = frame >> 1;
+	noInterrupts();
+	const bool ready = isReady();
+	interrupts();
+	if (!ready) return false;
+
+	this->processTransactionCallback = processTransactionCallback;
+	listenOnly = true;
+	requestPending = false;
+	response = 0;
+	responseTimestamp = micros();
+	resetEdgeFilter(responseTimestamp);
+	status = OpenThermStatus::RESPONSE_WAITING;
+	return true;
+}
+
+void OpenTherm::stopListening()
+{
+	if (!listenOnly) return;
+	listenOnly = false;
+	status = OpenThermStatus::DELAY;
+	responseTimestamp = micros();
+}
+
+void OpenTherm::setValueTable(OpenThermValue *values, byte count)
+{
+	valueTable = values;
+	valueTableSize = count;
+}
+
+void OpenTherm::setTrace(OpenThermTrace *trace)
+{
+	this->trace = trace;
+}
+
+void OpenTherm::traceTransaction(unsigned long request, unsigned long response, OpenThermResponseStatus status)
+{
+	if (trace != NULL) trace->push(millis(), request, response, status);
+}
+
+// Every frame on the bus is received as a response. A master frame is kept
+// until the slave frame with the same data ID completes the transaction.
+void OpenTherm::processListening(OpenThermStatus st, unsigned long ts, unsigned long newTs)
+{
+	if (st == OpenThermStatus::RESPONSE_READY && !parity(response)) {
+		const unsigned long frame = response;
+		if (getMessageType(frame) < READ_ACK) {
+			pendingRequest = frame;
+			requestPending = true;
+		}
+		else if (requestPending && getDataID(pendingRequest) == getDataID(frame)) {
+			if (isValidResponse(frame)) {
+				for (byte i = 0; i < valueTableSize; i++) {
+					if (valueTable[i].id == getDataID(frame)) {
+						valueTable[i].value = getUInt(frame);
+						valueTable[i].timestamp = millis();
+					}
+				}
+			}
+			traceTransaction(pendingRequest, frame, isValidResponse(frame) ? OpenThermResponseStatus::SUCCESS : OpenThermResponseStatus::INVALID);
+			if (processTransactionCallback != NULL) {
+				processTransactionCallback(pendingRequest, frame);
+			}
+			requestPending = false; // 0 is a valid request (READ_DATA Status), so it has its own flag
+		}
+	}
+	else if (st == OpenThermStatus::RESPONSE_WAITING) {
+		return;
 	}
-	return (p & 1);
+	else if (st != OpenThermStatus::RESPONSE_INVALID && (newTs - ts) <= OT_FRAME_IDLE_US) {
+		return; //frame still in progress
+	}
+
+	noInterrupts();
+	if (status == st) {
+		response = 0;
+		responseTimestamp = newTs;
+		status = OpenThermStatus::RESPONSE_WAITING;
+	}
+	interrupts();
+}
+
+void OpenTherm::resetEdgeFilter(unsigned long ts)
+{
+	lastEdgeTimestamp = ts;
+	previousEdgeTimestamp = ts;
+	lastEdgeState = readState();
+	edgeStatus = OpenThermStatus::NOT_INITIALIZED;
+}
+
+bool OpenTherm::parity(unsigned long frame) //odd parity
+{
+	// fold the frame into one nibble, then look its parity up in 0x6996
+	byte p = (byte)frame ^ (byte)(frame >> 8) ^ (byte)(frame >> 16) ^ (byte)(frame >> 24);
+	p ^= p >> 4;
+	return (0x6996 >> (p & 0x0F)) & 1;
 }
 
 unsigned long OpenTherm::buildRequest(OpenThermMessageType type, OpenThermMessageID id, unsigned int data)
@@ -209,7 +791,7 @@ unsigned long OpenTherm::buildRequest(OpenThermMessageType type, OpenThermMessag
 bool OpenTherm::isValidResponse(unsigned long response)
 {
 	if (parity(response)) return false;
-	byte msgType = (response << 1) >> 29;
+	OpenThermMessageType msgType = getMessageType(response);
 	return msgType == READ_ACK || msgType == WRITE_ACK;
 }
 
@@ -219,12 +801,57 @@ OpenThermMessageType OpenTherm::getMessageType(unsigned long message)
 	return msg_type;
 }
 
+OpenThermMessageID OpenTherm::getDataID(unsigned long frame)
+{
+	return static_cast<OpenThermMessageID>((frame >> 16) & 0xFF);
+}
+
 void OpenTherm::end() {
 	if (this->handleInterruptCallback != NULL) {		
 		detachInterrupt(digitalPinToInterrupt(inPin));
 	}
 }
 
+// Fletcher-16 over everything before the checksum field
+static uint16_t checkpointChecksum(const OpenThermCheckpoint &checkpoint)
+{
+	const byte *data = reinterpret_cast<const byte *>(&checkpoint);
+	uint16_t sum1 = 0, sum2 = 0;
+	for (size_t i = 0; i < offsetof(OpenThermCheckpoint, checksum); i++) {
+		sum1 = (sum1 + data[i]) % 255;
+		sum2 = (sum2 + sum1) % 255;
+	}
+	return (sum2 << 8) | sum1;
+}
+
+void OpenTherm::saveCheckpoint(OpenThermCheckpoint &checkpoint)
+{
+	memset(&checkpoint, 0, sizeof(checkpoint));
+	checkpoint.magic = OT_CHECKPOINT_MAGIC;
+	checkpoint.response = response;
+	checkpoint.propagationDelay = propagationDelay;
+	checkpoint.edgeSkew = edgeSkew;
+	checkpoint.responseStatus = responseStatus;
+	checkpoint.lineStatus = lineStatus;
+	checkpoint.txEchoSeen = txEchoSeen;
+	checkpoint.checksum = checkpointChecksum(checkpoint);
+}
+
+bool OpenTherm::restoreCheckpoint(const OpenThermCheckpoint &checkpoint)
+{
+	if (checkpoint.magic != OT_CHECKPOINT_MAGIC || checkpoint.checksum != checkpointChecksum(checkpoint)) {
+		return false;
+	}
+	response = checkpoint.response;
+	propagationDelay = checkpoint.propagationDelay;
+	edgeSkew = checkpoint.edgeSkew;
+	responseStatus = static_cast<OpenThermResponseStatus>(checkpoint.responseStatus);
+	// line faults are transient, a restored one would hold back the first requests
+	txEchoSeen = checkpoint.txEchoSeen;
+	warmStart = true;
+	return true;
+}
+
 #define OT_FSID(idx) string_##idx
 #define OT_FSTR(idx, s)  static const char OT_FSID(idx)[] PROGMEM = s
 
@@ -245,6 +872,25 @@ const char *OpenTherm::statusToString(OpenThermResponseStatus status)
 	}
 }
 
+const char *OpenTherm::lineStatusToString(OpenThermLineStatus status)
+{
+	OT_FSTR(_OT_LINE_OK,           "OK");
+	OT_FSTR(_OT_LINE_STUCK_ACTIVE, "STUCK_ACTIVE");
+	OT_FSTR(_OT_LINE_STUCK_IDLE,   "STUCK_IDLE");
+	OT_FSTR(_OT_LINE_NO_RESPONSE,  "NO_RESPONSE");
+	OT_FSTR(_OT_LINE_NOISY,        "NOISY");
+	OT_FSTR(_OT_LINE_UNKNOWN,      "UNKNOWN");
+
+	switch (status) {
+		case LINE_OK:           return OT_FSID(_OT_LINE_OK);
+		case LINE_STUCK_ACTIVE: return OT_FSID(_OT_LINE_STUCK_ACTIVE);
+		case LINE_STUCK_IDLE:   return OT_FSID(_OT_LINE_STUCK_IDLE);
+		case LINE_NO_RESPONSE:  return OT_FSID(_OT_LINE_NO_RESPONSE);
+		case LINE_NOISY:        return OT_FSID(_OT_LINE_NOISY);
+		default:                return OT_FSID(_OT_LINE_UNKNOWN);
+	}
+}
+
 const char *OpenTherm::messageTypeToString(OpenThermMessageType message_type)
 {
 	OT_FSTR(_OT_TYPE_READ_DATA,       "READ_DATA");
@@ -270,6 +916,373 @@ const char *OpenTherm::messageTypeToString(OpenThermMessageType message_type)
 	}
 }
 
+const char *OpenTherm::dataIdToString(OpenThermMessageID id)
+{
+	OT_FSTR(_OT_ID_Status,                     "Status");
+	OT_FSTR(_OT_ID_TSet,                       "TSet");
+	OT_FSTR(_OT_ID_MConfigMMemberIDcode,       "MConfigMMemberIDcode");
+	OT_FSTR(_OT_ID_SConfigSMemberIDcode,       "SConfigSMemberIDcode");
+	OT_FSTR(_OT_ID_Command,                    "Command");
+	OT_FSTR(_OT_ID_ASFflags,                   "ASFflags");
+	OT_FSTR(_OT_ID_RBPflags,                   "RBPflags");
+	OT_FSTR(_OT_ID_CoolingControl,             "CoolingControl");
+	OT_FSTR(_OT_ID_TsetCH2,                    "TsetCH2");
+	OT_FSTR(_OT_ID_TrOverride,                 "TrOverride");
+	OT_FSTR(_OT_ID_TSP,                        "TSP");
+	OT_FSTR(_OT_ID_TSPindexTSPvalue,           "TSPindexTSPvalue");
+	OT_FSTR(_OT_ID_FHBsize,                    "FHBsize");
+	OT_FSTR(_OT_ID_FHBindexFHBvalue,           "FHBindexFHBvalue");
+	OT_FSTR(_OT_ID_MaxRelModLevelSetting,      "MaxRelModLevelSetting");
+	OT_FSTR(_OT_ID_MaxCapacityMinModLevel,     "MaxCapacityMinModLevel");
+	OT_FSTR(_OT_ID_TrSet,                      "TrSet");
+	OT_FSTR(_OT_ID_RelModLevel,                "RelModLevel");
+	OT_FSTR(_OT_ID_CHPressure,                 "CHPressure");
+	OT_FSTR(_OT_ID_DHWFlowRate,                "DHWFlowRate");
+	OT_FSTR(_OT_ID_DayTime,                    "DayTime");
+	OT_FSTR(_OT_ID_Date,                       "Date");
+	OT_FSTR(_OT_ID_Year,                       "Year");
+	OT_FSTR(_OT_ID_TrSetCH2,                   "TrSetCH2");
+	OT_FSTR(_OT_ID_Tr,                         "Tr");
+	OT_FSTR(_OT_ID_Tboiler,                    "Tboiler");
+	OT_FSTR(_OT_ID_Tdhw,                       "Tdhw");
+	OT_FSTR(_OT_ID_Toutside,                   "Toutside");
+	OT_FSTR(_OT_ID_Tret,                       "Tret");
+	OT_FSTR(_OT_ID_Tstorage,                   "Tstorage");
+	OT_FSTR(_OT_ID_Tcollector,                 "Tcollector");
+	OT_FSTR(_OT_ID_TflowCH2,                   "TflowCH2");
+	OT_FSTR(_OT_ID_Tdhw2,                      "Tdhw2");
+	OT_FSTR(_OT_ID_Texhaust,                   "Texhaust");
+	OT_FSTR(_OT_ID_TdhwSetUBTdhwSetLB,         "TdhwSetUBTdhwSetLB");
+	OT_FSTR(_OT_ID_MaxTSetUBMaxTSetLB,         "MaxTSetUBMaxTSetLB");
+	OT_FSTR(_OT_ID_HcratioUBHcratioLB,         "HcratioUBHcratioLB");
+	OT_FSTR(_OT_ID_TdhwSet,                    "TdhwSet");
+	OT_FSTR(_OT_ID_MaxTSet,                    "MaxTSet");
+	OT_FSTR(_OT_ID_Hcratio,                    "Hcratio");
+	OT_FSTR(_OT_ID_RemoteOverrideFunction,     "RemoteOverrideFunction");
+	OT_FSTR(_OT_ID_OEMDiagnosticCode,          "OEMDiagnosticCode");
+	OT_FSTR(_OT_ID_BurnerStarts,               "BurnerStarts");
+	OT_FSTR(_OT_ID_CHPumpStarts,               "CHPumpStarts");
+	OT_FSTR(_OT_ID_DHWPumpValveStarts,         "DHWPumpValveStarts");
+	OT_FSTR(_OT_ID_DHWBurnerStarts,            "DHWBurnerStarts");
+	OT_FSTR(_OT_ID_BurnerOperationHours,       "BurnerOperationHours");
+	OT_FSTR(_OT_ID_CHPumpOperationHours,       "CHPumpOperationHours");
+	OT_FSTR(_OT_ID_DHWPumpValveOperationHours, "DHWPumpValveOperationHours");
+	OT_FSTR(_OT_ID_DHWBurnerOperationHours,    "DHWBurnerOperationHours");
+	OT_FSTR(_OT_ID_OpenThermVersionMaster,     "OpenThermVersionMaster");
+	OT_FSTR(_OT_ID_OpenThermVersionSlave,      "OpenThermVersionSlave");
+	OT_FSTR(_OT_ID_MasterVersion,              "MasterVersion");
+	OT_FSTR(_OT_ID_SlaveVersion,               "SlaveVersion");
+
+	switch (id) {
+		case Status:                     return OT_FSID(_OT_ID_Status);
+		case TSet:                       return OT_FSID(_OT_ID_TSet);
+		case MConfigMMemberIDcode:       return OT_FSID(_OT_ID_MConfigMMemberIDcode);
+		case SConfigSMemberIDcode:       return OT_FSID(_OT_ID_SConfigSMemberIDcode);
+		case Command:                    return OT_FSID(_OT_ID_Command);
+		case ASFflags:                   return OT_FSID(_OT_ID_ASFflags);
+		case RBPflags:                   return OT_FSID(_OT_ID_RBPflags);
+		case CoolingControl:             return OT_FSID(_OT_ID_CoolingControl);
+		case TsetCH2:                    return OT_FSID(_OT_ID_TsetCH2);
+		case TrOverride:                 return OT_FSID(_OT_ID_TrOverride);
+		case TSP:                        return OT_FSID(_OT_ID_TSP);
+		case TSPindexTSPvalue:           return OT_FSID(_OT_ID_TSPindexTSPvalue);
+		case FHBsize:                    return OT_FSID(_OT_ID_FHBsize);
+		case FHBindexFHBvalue:           return OT_FSID(_OT_ID_FHBindexFHBvalue);
+		case MaxRelModLevelSetting:      return OT_FSID(_OT_ID_MaxRelModLevelSetting);
+		case MaxCapacityMinModLevel:     return OT_FSID(_OT_ID_MaxCapacityMinModLevel);
+		case TrSet:                      return OT_FSID(_OT_ID_TrSet);
+		case RelModLevel:                return OT_FSID(_OT_ID_RelModLevel);
+		case CHPressure:                 return OT_FSID(_OT_ID_CHPressure);
+		case DHWFlowRate:                return OT_FSID(_OT_ID_DHWFlowRate);
+		case DayTime:                    return OT_FSID(_OT_ID_DayTime);
+		case Date:                       return OT_FSID(_OT_ID_Date);
+		case Year:                       return OT_FSID(_OT_ID_Year);
+		case TrSetCH2:                   return OT_FSID(_OT_ID_TrSetCH2);
+		case Tr:                         return OT_FSID(_OT_ID_Tr);
+		case Tboiler:                    return OT_FSID(_OT_ID_Tboiler);
+		case Tdhw:                       return OT_FSID(_OT_ID_Tdhw);
+		case Toutside:                   return OT_FSID(_OT_ID_Toutside);
+		case Tret:                       return OT_FSID(_OT_ID_Tret);
+		case Tstorage:                   return OT_FSID(_OT_ID_Tstorage);
+		case Tcollector:                 return OT_FSID(_OT_ID_Tcollector);
+		case TflowCH2:                   return OT_FSID(_OT_ID_TflowCH2);
+		case Tdhw2:                      return OT_FSID(_OT_ID_Tdhw2);
+		case Texhaust:                   return OT_FSID(_OT_ID_Texhaust);
+		case TdhwSetUBTdhwSetLB:         return OT_FSID(_OT_ID_TdhwSetUBTdhwSetLB);
+		case MaxTSetUBMaxTSetLB:         return OT_FSID(_OT_ID_MaxTSetUBMaxTSetLB);
+		case HcratioUBHcratioLB:         return OT_FSID(_OT_ID_HcratioUBHcratioLB);
+		case TdhwSet:                    return OT_FSID(_OT_ID_TdhwSet);
+		case MaxTSet:                    return OT_FSID(_OT_ID_MaxTSet);
+		case Hcratio:                    return OT_FSID(_OT_ID_Hcratio);
+		case RemoteOverrideFunction:     return OT_FSID(_OT_ID_RemoteOverrideFunction);
+		case OEMDiagnosticCode:          return OT_FSID(_OT_ID_OEMDiagnosticCode);
+		case BurnerStarts:               return OT_FSID(_OT_ID_BurnerStarts);
+		case CHPumpStarts:               return OT_FSID(_OT_ID_CHPumpStarts);
+		case DHWPumpValveStarts:         return OT_FSID(_OT_ID_DHWPumpValveStarts);
+		case DHWBurnerStarts:            return OT_FSID(_OT_ID_DHWBurnerStarts);
+		case BurnerOperationHours:       return OT_FSID(_OT_ID_BurnerOperationHours);
+		case CHPumpOperationHours:       return OT_FSID(_OT_ID_CHPumpOperationHours);
+		case DHWPumpValveOperationHours: return OT_FSID(_OT_ID_DHWPumpValveOperationHours);
+		case DHWBurnerOperationHours:    return OT_FSID(_OT_ID_DHWBurnerOperationHours);
+		case OpenThermVersionMaster:     return OT_FSID(_OT_ID_OpenThermVersionMaster);
+		case OpenThermVersionSlave:      return OT_FSID(_OT_ID_OpenThermVersionSlave);
+		case MasterVersion:              return OT_FSID(_OT_ID_MasterVersion);
+		case SlaveVersion:               return OT_FSID(_OT_ID_SlaveVersion);
+		default:                         return NULL;
+	}
+}
+
+OpenThermDataType OpenTherm::getDataType(OpenThermMessageID id)
+{
+	switch (id) {
+		case Status:
+		case RBPflags:
+			return OT_FLAG8_FLAG8;
+		case MConfigMMemberIDcode:
+		case SConfigSMemberIDcode:
+		case ASFflags:
+		case RemoteOverrideFunction:
+			return OT_FLAG8_U8;
+		case Command:
+		case TSP:
+		case TSPindexTSPvalue:
+		case FHBsize:
+		case FHBindexFHBvalue:
+		case MaxCapacityMinModLevel:
+		case DayTime:
+		case Date:
+		case MasterVersion:
+		case SlaveVersion:
+			return OT_U8_U8;
+		case TdhwSetUBTdhwSetLB:
+		case MaxTSetUBMaxTSetLB:
+		case HcratioUBHcratioLB:
+			return OT_S8_S8;
+		case Texhaust:
+			return OT_S16;
+		case Year:
+		case OEMDiagnosticCode:
+		case BurnerStarts:
+		case CHPumpStarts:
+		case DHWPumpValveStarts:
+		case DHWBurnerStarts:
+		case BurnerOperationHours:
+		case CHPumpOperationHours:
+		case DHWPumpValveOperationHours:
+		case DHWBurnerOperationHours:
+			return OT_U16;
+		case TSet:
+		case CoolingControl:
+		case TsetCH2:
+		case TrOverride:
+		case MaxRelModLevelSetting:
+		case TrSet:
+		case RelModLevel:
+		case CHPressure:
+		case DHWFlowRate:
+		case TrSetCH2:
+		case Tr:
+		case Tboiler:
+		case Tdhw:
+		case Toutside:
+		case Tret:
+		case Tstorage:
+		case Tcollector:
+		case TflowCH2:
+		case Tdhw2:
+		case TdhwSet:
+		case MaxTSet:
+		case Hcratio:
+		case OpenThermVersionMaster:
+		case OpenThermVersionSlave:
+			return OT_F88;
+		default:
+			return OT_UNKNOWN_TYPE;
+	}
+}
+
+// Bounded writer for frameToString(), always leaves the buffer NUL terminated.
+struct OpenThermTextWriter {
+	char *p;
+	char *const end;
+
+	OpenThermTextWriter(char *buffer, size_t size): p(buffer), end(buffer + size - 1) {}
+	void put(char c) { if (p < end) *p++ = c; }
+	void putP(const char *s) { for (char c; (c = pgm_read_byte(s)) != 0; s++) put(c); }
+	void putUInt(unsigned long v) {
+		char digits[10];
+		byte n = 0;
+		do { digits[n++] = '0' + v % 10; v /= 10; } while (v > 0);
+		while (n > 0) put(digits[--n]);
+	}
+	void putInt(long v) {
+		if (v < 0) { put('-'); v = -v; }
+		putUInt(v);
+	}
+	void putHex(unsigned long v, byte digits) {
+		while (digits > 0) {
+			digits--;
+			byte d = (v >> (digits * 4)) & 0xF;
+			put(d < 10 ? '0' + d : 'A' + d - 10);
+		}
+	}
+	// f8.8 rounded half away from zero, a * 10^4 still fits 32 bits
+	void putF88(uint16_t u88, byte decimals) {
+		if (decimals > OT_MAX_DECIMALS) decimals = OT_MAX_DECIMALS;
+		unsigned long a = (u88 & 0x8000) ? 0x10000L - u88 : u88;
+		unsigned long scale = 1;
+		for (byte i = 0; i < decimals; i++) scale *= 10;
+		const unsigned long scaled = (a * scale + 128) >> 8;
+		if ((u88 & 0x8000) && scaled != 0) put('-');
+		putUInt(scaled / scale);
+		if (decimals == 0) return;
+		put('.');
+		for (unsigned long frac = scaled % scale; scale > 1; ) {
+			scale /= 10;
+			put('0' + frac / scale);
+			frac %= scale;
+		}
+	}
+	void putValue(uint16_t value, OpenThermDataType type, byte decimals) {
+		switch (type) {
+			case OT_F88:
+				putF88(value, decimals);
+				break;
+			case OT_S16:
+				putInt((int16_t)value);
+				break;
+			case OT_U16:
+				putUInt(value);
+				break;
+			case OT_S8_S8:
+				putInt((int8_t)(value >> 8));
+				put('/');
+				putInt((int8_t)(value & 0xFF));
+				break;
+			case OT_U8_U8:
+				putUInt(value >> 8);
+				put('/');
+				putUInt(value & 0xFF);
+				break;
+			case OT_FLAG8_U8:
+				put('0'); put('x'); putHex(value >> 8, 2);
+				put('/');
+				putUInt(value & 0xFF);
+				break;
+			case OT_FLAG8_FLAG8:
+				put('0'); put('x'); putHex(value >> 8, 2);
+				put('/');
+				put('0'); put('x'); putHex(value & 0xFF, 2);
+				break;
+			default:
+				put('0'); put('x'); putHex(value, 4);
+		}
+	}
+	size_t finish(char *buffer) {
+		*p = 0;
+		return p - buffer;
+	}
+	// names of the set bits, taken in order from a space separated list
+	void putFlags(const char *names, byte flags) {
+		put('[');
+		bool first = true;
+		for (byte bit = 0; bit < 8; bit++) {
+			char c = pgm_read_byte(names);
+			if ((flags >> bit) & 1) {
+				if (!first) put(' ');
+				first = false;
+				if (c == 0) { put('b'); putUInt(bit); }
+			}
+			for (; c != 0 && c != ' '; c = pgm_read_byte(++names)) {
+				if ((flags >> bit) & 1) put(c);
+			}
+			if (c == ' ') names++;
+		}
+		put(']');
+	}
+};
+
+size_t OpenTherm::frameToString(unsigned long frame, char *buffer, size_t size)
+{
+	OT_FSTR(_OT_DIR_MASTER,     "M>S ");
+	OT_FSTR(_OT_DIR_SLAVE,      "S>M ");
+	OT_FSTR(_OT_MASTER_FLAGS,   "CH DHW COOL OTC CH2");
+	OT_FSTR(_OT_SLAVE_FLAGS,    "FAULT CH DHW FLAME COOL CH2 DIAG");
+	OT_FSTR(_OT_ID_PREFIX,      "id=");
+	OT_FSTR(_OT_UNIT_DEGC,      " degC");
+	OT_FSTR(_OT_UNIT_PERCENT,   " %");
+	OT_FSTR(_OT_UNIT_BAR,       " bar");
+	OT_FSTR(_OT_UNIT_LPM,       " l/min");
+	OT_FSTR(_OT_UNIT_HOURS,     " h");
+	OT_FSTR(_OT_PARITY_ERROR,   " PARITY_ERROR");
+
+	if (size == 0) return 0;
+	OpenThermTextWriter w(buffer, size);
+	const OpenThermMessageType type = getMessageType(frame);
+	const OpenThermMessageID id = getDataID(frame);
+	const uint16_t u16 = getUInt(frame);
+
+	w.putP(type < READ_ACK ? OT_FSID(_OT_DIR_MASTER) : OT_FSID(_OT_DIR_SLAVE));
+	w.putP(messageTypeToString(type));
+	w.put(' ');
+	const char *name = dataIdToString(id);
+	if (name != NULL) {
+		w.putP(name);
+	}
+	else {
+		w.putP(OT_FSID(_OT_ID_PREFIX));
+		w.putUInt(id);
+	}
+	w.put(' ');
+
+	const OpenThermDataType dataType = getDataType(id);
+	if (id == Status) {
+		w.putFlags(OT_FSID(_OT_MASTER_FLAGS), u16 >> 8);
+		w.put('/');
+		w.putFlags(OT_FSID(_OT_SLAVE_FLAGS), u16 & 0xFF);
+	}
+	else {
+		w.putValue(u16, dataType, 2);
+	}
+
+	switch (id) {
+		case CoolingControl:
+		case MaxRelModLevelSetting:
+		case RelModLevel:
+			w.putP(OT_FSID(_OT_UNIT_PERCENT));
+			break;
+		case CHPressure:
+			w.putP(OT_FSID(_OT_UNIT_BAR));
+			break;
+		case DHWFlowRate:
+			w.putP(OT_FSID(_OT_UNIT_LPM));
+			break;
+		case BurnerOperationHours:
+		case CHPumpOperationHours:
+		case DHWPumpValveOperationHours:
+		case DHWBurnerOperationHours:
+			w.putP(OT_FSID(_OT_UNIT_HOURS));
+			break;
+		case Hcratio:
+		case OpenThermVersionMaster:
+		case OpenThermVersionSlave:
+			break;
+		default:
+			if (dataType == OT_F88 || dataType == OT_S16) w.putP(OT_FSID(_OT_UNIT_DEGC));
+	}
+
+	if (parity(frame)) w.putP(OT_FSID(_OT_PARITY_ERROR));
+	return w.finish(buffer);
+}
+
+size_t OpenTherm::valueToString(uint16_t value, OpenThermDataType type, char *buffer, size_t size, byte decimals)
+{
+	if (size == 0) return 0;
+	OpenThermTextWriter w(buffer, size);
+	w.putValue(value, type, decimals);
+	return w.finish(buffer);
+}
+
 //building requests
 
 unsigned long OpenTherm::buildSetBoilerStatusRequest(bool enableCentralHeating, bool enableHotWater, bool enableCooling, bool enableOutsideTemperatureCompensation, bool enableCentralHeating2) {
@@ -312,12 +1325,12 @@ bool OpenTherm::isDiagnostic(unsigned long response) {
 	return response & 0x40;
 }
 
-uint16_t OpenTherm::getUInt(const unsigned long response) const {
+uint16_t OpenTherm::getUInt(const unsigned long response) {
 	const uint16_t u88 = response & 0xffff;
 	return u88;
 }
 
-float OpenTherm::getFloat(const unsigned long response) const {
+float OpenTherm::getFloat(const unsigned long response) {
 	const uint16_t u88 = getUInt(response);
 	const float f = (u88 & 0x8000) ? -(0x10000L - u88) / 256.0f : u88 / 256.0f;
 	return f;
@@ -14,6 +14,7 @@ P MGS-TYPE SPARE DATA-ID  DATA-VALUE
 #define OpenTherm_h
 
 #include <stdint.h>
+#include <stddef.h>
 #include <Arduino.h>
 
 namespace OT {
@@ -99,6 +100,25 @@ enum OpenThermMessageID {
 	SlaveVersion, // u8 / u8  Slave product version number and type
 };
 
+enum OpenThermDataType {
+	OT_UNKNOWN_TYPE,
+	OT_F88, // signed fixed point, 8 integer and 8 fraction bits
+	OT_U16,
+	OT_S16,
+	OT_U8_U8,
+	OT_S8_S8,
+	OT_FLAG8_U8,
+	OT_FLAG8_FLAG8
+};
+
+enum OpenThermLineStatus {
+	LINE_OK,
+	LINE_STUCK_ACTIVE, // input active while the bus should be idle, transmission suspended
+	LINE_STUCK_IDLE, // loopback adapter did not echo our request
+	LINE_NO_RESPONSE, // repeated timeouts without a single response edge
+	LINE_NOISY // repeated invalid or incomplete responses
+};
+
 enum OpenThermStatus {
 	NOT_INITIALIZED,
 	READY,
@@ -111,6 +131,28 @@ enum OpenThermStatus {
 	RESPONSE_INVALID	
 };
 
+// Latest value of one data ID seen on the bus, see setValueTable()
+struct OpenThermValue {
+	OpenThermMessageID id;
+	uint16_t value;
+	unsigned long timestamp; // millis() when seen, 0 if never
+};
+
+class OpenThermTrace;
+
+// Compact engine state for RTC or no-init RAM, see saveCheckpoint()
+struct OpenThermCheckpoint {
+	uint32_t magic;
+	uint32_t response;
+	uint16_t propagationDelay;
+	int16_t edgeSkew;
+	uint8_t responseStatus;
+	uint8_t lineStatus; // at save time, for diagnostics only, faults are re-detected after restore
+	uint8_t txEchoSeen;
+	uint8_t reserved;
+	uint16_t checksum;
+};
+
 class OpenTherm
 {
 private:
@@ -122,15 +164,81 @@ private:
 	volatile OpenThermResponseStatus responseStatus;
 	volatile unsigned long responseTimestamp;
 	volatile byte responseBitIndex;
+	unsigned long request;
+	volatile byte txEchoEdgeCount;
+	bool txEchoSuppression;
+	bool singleEdgeDecoding;
+	bool warmStart;
+	OpenTherm *repeatTarget;
+	bool listenOnly;
+	unsigned long pendingRequest;
+	bool requestPending;
+	OpenThermValue *valueTable;
+	byte valueTableSize;
+	OpenThermTrace *trace;
+
+	// batch in progress, batchRequests is NULL when idle
+	const unsigned long *batchRequests;
+	unsigned long *batchResponses;
+	OpenThermResponseStatus *batchStatuses;
+	byte batchCount;
+	byte batchIndex;
+	byte batchStopMask;
+	bool batchInFlight; // the frame on the bus was sent by the batch, not by the caller
+	// load shedding, see setLoadShedding()
+	unsigned long maxLateness;
+	unsigned long processLateness;
+	bool overloaded;
+	unsigned long overloadTimestamp;
+	unsigned long lastProcessTimestamp;
+	unsigned int shedCount;
+	bool txEchoSeen;
+	OpenThermLineStatus lineStatus;
+	byte noResponseCount;
+	unsigned long lastSendTimestamp;
+	bool lineFaultBackoff;
+	byte invalidResponseCount;
+	unsigned int propagationDelay;
+	int edgeSkew;
+	byte skewCompensation;
+
+	// glitch filter: last raw edge and the decoder state it replaced
+	unsigned int glitchFilterWidth;
+	volatile unsigned long lastEdgeTimestamp;
+	volatile unsigned long previousEdgeTimestamp;
+	volatile byte lastEdgeState;
+	volatile OpenThermStatus edgeStatus;
+	volatile OpenThermStatus preEdgeStatus;
+	volatile unsigned long preEdgeResponse;
+	volatile unsigned long preEdgeTimestamp;
+	volatile byte preEdgeBitIndex;
 	
 	int readState();
 	void setActiveState();
 	void setIdleState();	
 	void activateBoiler();
 
-	void sendBit(bool high);
+	void sendHalfBit(bool active, int skew);
+	bool filterGlitch(unsigned long newTs);
+	bool isEdgeExpected();
+	void repeatEdge();
+	void decodeEdge(unsigned long newTs);
+	void decodeActiveEdge(unsigned long newTs);
+	bool waitState(int state, unsigned long &elapsed);
+	bool isLineStuckActive();
+	void updateLineStatus(OpenThermStatus st);
+	void resetEdgeFilter(unsigned long ts);
+	void processListening(OpenThermStatus st, unsigned long ts, unsigned long newTs);
+	void traceTransaction(unsigned long request, unsigned long response, OpenThermResponseStatus status);
 	void(*handleInterruptCallback)();
 	void(*processResponseCallback)(unsigned long, OpenThermResponseStatus);
+	void(*processTransactionCallback)(unsigned long, unsigned long);
+	void(*processBatchCallback)(byte);
+	bool sendBatchRequest();
+	void completeBatchRequest();
+	void updateLoad(unsigned long lateness, unsigned long now);
+	void expireOverload(unsigned long now);
+	void finishBatch();
 public:	
 	OpenTherm(int inPin = 4, int outPin = 5);
 	void begin(void(*handleInterruptCallback)(void));
@@ -138,33 +246,76 @@ public:
 	bool isReady();
 	unsigned long sendRequest(unsigned long request);
 	bool sendRequestAync(unsigned long request);
-	unsigned long buildRequest(OpenThermMessageType type, OpenThermMessageID id, unsigned int data);
+	static unsigned long buildRequest(OpenThermMessageType type, OpenThermMessageID id, unsigned int data);
+	// Batch of requests run back to back, responses[i] and statuses[i] are filled
+	// in order. The batch stops early after a status in stopMask (bit per
+	// OpenThermResponseStatus) or when a request cannot be sent.
+	bool sendRequestBatchAsync(const unsigned long *requests, unsigned long *responses, OpenThermResponseStatus *statuses, byte count,
+		void(*processBatchCallback)(byte completed), byte stopMask = 1 << TIMEOUT);
+	byte sendRequestBatch(const unsigned long *requests, unsigned long *responses, OpenThermResponseStatus *statuses, byte count,
+		byte stopMask = 1 << TIMEOUT); // returns number of completed requests
+	// While process() runs more than maxLateness us late, and for 1 s after the
+	// last late event, batches skip READ_DATA requests other than Status; they
+	// get status NONE. Writes are always sent.
+	void setLoadShedding(unsigned long maxLateness); // us, 0 disables
+	unsigned long getProcessLateness(); // us, how late process() handled the last bus event
+	bool isOverloaded();
+	byte getQueueDepth(); // batch requests not yet completed
+	unsigned int getShedCount();
 	OpenThermResponseStatus getLastResponseStatus();
-	const char *statusToString(OpenThermResponseStatus status);
+	static const char *statusToString(OpenThermResponseStatus status);
 	void handleInterrupt();	
+	void handleInterrupt(unsigned long timestamp); // edge time from an input capture unit, in micros() time base
+	void setGlitchFilter(unsigned int minPulseWidth); // us, 0 disables
+	void setSingleEdgeDecoding(bool enable); // interrupt on idle to active edges only, call before begin(), disables the repeater
+	bool setRepeater(OpenTherm *target); // mirror every input edge to the target's output, NULL disables; false in single edge mode
+	bool startListening(void(*processTransactionCallback)(unsigned long request, unsigned long response) = NULL); // passive mode, call after begin()
+	void stopListening();
+	void setValueTable(OpenThermValue *values, byte count); // latest values of these IDs, updated while listening
+	void setTrace(OpenThermTrace *trace); // record every completed transaction, NULL disables
+	void setTxEchoSuppression(bool enable); // detach input interrupt while sending
+	byte getTxEchoEdgeCount(); // input edges seen while sending the last request
+	bool isTxEchoValid(); // loopback self-test, requires echo suppression off
+	OpenThermLineStatus getLineStatus();
+	void setLineFaultBackoff(bool enable); // one probe per 5 s while STUCK_IDLE or NO_RESPONSE, off by default
+	bool calibrateLoopback(); // measure adapter delays through the TX to RX loopback, call after begin()
+	unsigned int getPropagationDelay(); // us, average of rise and fall delay
+	int getEdgeSkew(); // us, fall delay minus rise delay of TX and RX together
+	void setSkewCompensation(byte txSharePercent); // part of the edge skew taken off when sending, 0 (default) disables
+	static const char *lineStatusToString(OpenThermLineStatus status);
 	void process();
 	void end();
-	OpenThermMessageType getMessageType(unsigned long message);
-	const char *messageTypeToString(OpenThermMessageType message_type);
-	bool parity(unsigned long frame);
-	bool isValidResponse(unsigned long response);
+	void saveCheckpoint(OpenThermCheckpoint &checkpoint);
+	bool restoreCheckpoint(const OpenThermCheckpoint &checkpoint); // call before begin(), a valid checkpoint skips boiler activation
+
+	//frame helpers, usable without an instance (e.g. for decoding recorded traces)
+	static OpenThermMessageType getMessageType(unsigned long message);
+	static OpenThermMessageID getDataID(unsigned long frame);
+	static const char *messageTypeToString(OpenThermMessageType message_type);
+	static bool parity(unsigned long frame);
+	static bool isValidResponse(unsigned long response);
+	static const char *dataIdToString(OpenThermMessageID id); // NULL for IDs without a name
+	static OpenThermDataType getDataType(OpenThermMessageID id);
+	static size_t frameToString(unsigned long frame, char *buffer, size_t size); // returns length written
+	static size_t valueToString(uint16_t value, OpenThermDataType type, char *buffer, size_t size, byte decimals = 2); // integer only, decimals 0..4 for f8.8
+	static bool isHalfBitActive(unsigned long frame, byte index); // Manchester line level, index 0..67 from the start bit
 
 	//building requests
-	unsigned long buildSetBoilerStatusRequest(bool enableCentralHeating, bool enableHotWater = false, bool enableCooling = false, bool enableOutsideTemperatureCompensation = false, bool enableCentralHeating2 = false);
-	unsigned long buildSetBoilerTemperatureRequest(float temperature);
-	unsigned long buildGetBoilerTemperatureRequest();
+	static unsigned long buildSetBoilerStatusRequest(bool enableCentralHeating, bool enableHotWater = false, bool enableCooling = false, bool enableOutsideTemperatureCompensation = false, bool enableCentralHeating2 = false);
+	static unsigned long buildSetBoilerTemperatureRequest(float temperature);
+	static unsigned long buildGetBoilerTemperatureRequest();
 
 	//parsing responses
-	bool isFault(unsigned long response);
-	bool isCentralHeatingEnabled(unsigned long response);
-	bool isHotWaterEnabled(unsigned long response);
-	bool isFlameOn(unsigned long response);
-	bool isCoolingEnabled(unsigned long response);
-	bool isDiagnostic(unsigned long response);
-	uint16_t getUInt(const unsigned long response) const;
-	float getFloat(const unsigned long response) const;
-	float getTemperature(unsigned long response);
-	unsigned int temperatureToData(float temperature);
+	static bool isFault(unsigned long response);
+	static bool isCentralHeatingEnabled(unsigned long response);
+	static bool isHotWaterEnabled(unsigned long response);
+	static bool isFlameOn(unsigned long response);
+	static bool isCoolingEnabled(unsigned long response);
+	static bool isDiagnostic(unsigned long response);
+	static uint16_t getUInt(const unsigned long response);
+	static float getFloat(const unsigned long response);
+	static float getTemperature(unsigned long response);
+	static unsigned int temperatureToData(float temperature);
 
 	//basic requests
 	unsigned long setBoilerStatus(bool enableCentralHeating, bool enableHotWater = false, bool enableCooling = false, bool enableOutsideTemperatureCompensation = false, bool enableCentralHeating2 = false);	
@@ -0,0 +1,114 @@
+/*
+OpenThermCoalescer.cpp - Collects decoded OpenTherm values and publishes only changes
+Licensed under MIT license
+*/
+
+#include "OpenThermCoalescer.h"
+namespace OT {
+
+enum OpenThermSlotState {
+	SLOT_FREE,
+	SLOT_NEW, // never published
+	SLOT_SEEN
+};
+
+OpenThermCoalescer::OpenThermCoalescer(OpenThermCoalescerSlot *slots, byte size, unsigned long window):
+	slots(slots),
+	size(size),
+	window(window),
+	lastFlush(0),
+	droppedCount(0)
+{
+	for (byte i = 0; i < size; i++) {
+		slots[i].state = SLOT_FREE;
+	}
+}
+
+// Returns false if all slots are taken by other IDs with unpublished changes.
+bool OpenThermCoalescer::add(OpenThermMessageID id, uint16_t value, unsigned long timestamp)
+{
+	OpenThermCoalescerSlot *target = NULL;
+	OpenThermCoalescerSlot *reusable = NULL;
+	for (byte i = 0; i < size; i++) {
+		OpenThermCoalescerSlot &slot = slots[i];
+		if (slot.state != SLOT_FREE && slot.value.id == id) {
+			target = &slot;
+			break;
+		}
+		// an unused slot, or else one whose value is already published
+		if (slot.state == SLOT_FREE) {
+			if (reusable == NULL || reusable->state != SLOT_FREE) reusable = &slot;
+		}
+		else if (reusable == NULL && slot.state == SLOT_SEEN && slot.value.value == slot.publishedValue) {
+			reusable = &slot;
+		}
+	}
+	if (target == NULL) {
+		if (reusable == NULL) {
+			droppedCount++;
+			return false;
+		}
+		target = reusable;
+		target->value.id = id;
+		target->state = SLOT_NEW;
+	}
+	target->value.value = value;
+	target->value.timestamp = timestamp;
+	return true;
+}
+
+bool OpenThermCoalescer::addResponse(unsigned long response, unsigned long timestamp)
+{
+	if (!OpenTherm::isValidResponse(response)) return false;
+	return add(OpenTherm::getDataID(response), OpenTherm::getUInt(response), timestamp);
+}
+
+// Publishes changed values once per window, returns the number published.
+byte OpenThermCoalescer::process(unsigned long now, byte(*publish)(const OpenThermValue *values, byte count))
+{
+	if (now - lastFlush < window) return 0;
+	lastFlush = now;
+
+	OpenThermValue batch[BATCH_SIZE];
+	byte index[BATCH_SIZE];
+	byte published = 0;
+	byte i = 0;
+	while (i < size) {
+		byte count = 0;
+		for (; i < size && count < BATCH_SIZE; i++) {
+			const OpenThermCoalescerSlot &slot = slots[i];
+			if (slot.state == SLOT_NEW || (slot.state == SLOT_SEEN && slot.value.value != slot.publishedValue)) {
+				batch[count] = slot.value;
+				index[count] = i;
+				count++;
+			}
+		}
+		if (count == 0) break;
+		const byte accepted = publish(batch, count);
+		for (byte j = 0; j < accepted && j < count; j++) {
+			OpenThermCoalescerSlot &slot = slots[index[j]];
+			slot.publishedValue = batch[j].value;
+			slot.state = SLOT_SEEN;
+		}
+		published += accepted;
+		if (accepted < count) break; // sink is busy, retry next window
+	}
+	return published;
+}
+
+byte OpenThermCoalescer::getPendingCount() const
+{
+	byte pending = 0;
+	for (byte i = 0; i < size; i++) {
+		const OpenThermCoalescerSlot &slot = slots[i];
+		if (slot.state == SLOT_NEW || (slot.state == SLOT_SEEN && slot.value.value != slot.publishedValue)) pending++;
+	}
+	return pending;
+}
+
+unsigned int OpenThermCoalescer::getDroppedCount() const
+{
+	return droppedCount;
+}
+
+} // namespace OT
@@ -0,0 +1,49 @@
+/*
+OpenThermCoalescer.h - Collects decoded OpenTherm values and publishes only changes
+Licensed under MIT license
+
+Values are kept in caller supplied slots, one per data ID. A newer value
+replaces the pending one of the same ID, so memory is bounded by the number
+of slots. Every window the changed values are handed to the publish callback
+in batches; the callback returns how many it accepted, the rest stays
+pending for the next window. Nothing here blocks, so it is safe to call
+from the same loop as OpenTherm::process().
+*/
+
+#ifndef OpenThermCoalescer_h
+#define OpenThermCoalescer_h
+
+#include <stdint.h>
+#include <Arduino.h>
+#include "OpenTherm.h"
+
+namespace OT {
+
+struct OpenThermCoalescerSlot {
+	OpenThermValue value;
+	uint16_t publishedValue;
+	uint8_t state;
+};
+
+class OpenThermCoalescer
+{
+private:
+	OpenThermCoalescerSlot *slots;
+	const byte size;
+	const unsigned long window;
+	unsigned long lastFlush;
+	unsigned int droppedCount;
+public:
+	static const byte BATCH_SIZE = 8;
+
+	OpenThermCoalescer(OpenThermCoalescerSlot *slots, byte size, unsigned long window);
+	bool add(OpenThermMessageID id, uint16_t value, unsigned long timestamp);
+	bool addResponse(unsigned long response, unsigned long timestamp);
+	byte process(unsigned long now, byte(*publish)(const OpenThermValue *values, byte count));
+	byte getPendingCount() const;
+	unsigned int getDroppedCount() const;
+};
+
+} // namespace OT
+
+#endif // OpenThermCoalescer_h
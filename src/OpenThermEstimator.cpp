@@ -0,0 +1,84 @@
+/*
+OpenThermEstimator.cpp - Predicts slowly changing OpenTherm values between polls
+Licensed under MIT license
+*/
+
+#include "OpenThermEstimator.h"
+namespace OT {
+
+static const byte OT_ESTIMATOR_ALPHA_SHIFT = 1; // level gain 1/2
+static const byte OT_ESTIMATOR_BETA_SHIFT = 3;  // trend gain 1/8
+static const byte OT_ESTIMATOR_ERROR_SHIFT = 2; // error rate averages over ~4 polls
+static const uint16_t OT_ESTIMATOR_MAX_BOUND = 0xFFFF;
+static const byte OT_ESTIMATOR_BOUND_SHIFT = 1; // bound is twice the mean error
+static const byte OT_ESTIMATOR_MIN_SAMPLES = 3;  // level, trend and error rate need this many polls
+
+OpenThermEstimator::OpenThermEstimator():
+	samples(0),
+	lastTimestamp(0),
+	level(0),
+	trend(0),
+	errorRate(0)
+{
+}
+
+void OpenThermEstimator::invalidate()
+{
+	samples = 0;
+}
+
+int32_t OpenThermEstimator::predict(unsigned long timestamp) const
+{
+	const int64_t dt = (uint32_t)(timestamp - lastTimestamp);
+	int64_t p = level + ((trend * dt) >> 12);
+	if (p > 32767) p = 32767;
+	if (p < -32768) p = -32768;
+	return (int32_t)p;
+}
+
+void OpenThermEstimator::update(unsigned long timestamp, uint16_t value)
+{
+	const int32_t measured = (int16_t)value;
+	const uint32_t dt = timestamp - lastTimestamp;
+	if (samples == 0 || dt == 0) {
+		level = measured;
+		trend = 0;
+		lastTimestamp = timestamp;
+		samples = 1;
+		return;
+	}
+
+	const int32_t predicted = predict(timestamp);
+	const int32_t residual = measured - predicted;
+	const uint32_t absResidual = residual < 0 ? -residual : residual;
+	// |residual| <= 65535 as both sides are 16 bit, so the Q12 slope fits 32 bits
+	const uint32_t rate = (absResidual << 12) / dt;
+	if (samples == 1) errorRate = rate;
+	else errorRate += ((int32_t)rate - (int32_t)errorRate) >> OT_ESTIMATOR_ERROR_SHIFT;
+	if (samples < 255) samples++;
+
+	level = predicted + (residual >> OT_ESTIMATOR_ALPHA_SHIFT);
+	trend += (residual < 0 ? -(int32_t)rate : (int32_t)rate) >> OT_ESTIMATOR_BETA_SHIFT;
+	lastTimestamp = timestamp;
+}
+
+// Returns the predicted raw data value, bound is the expected +/- error in the same units.
+uint16_t OpenThermEstimator::estimate(unsigned long timestamp, uint16_t &bound) const
+{
+	if (samples < OT_ESTIMATOR_MIN_SAMPLES) {
+		bound = OT_ESTIMATOR_MAX_BOUND;
+		return samples == 0 ? 0 : (uint16_t)(int16_t)level;
+	}
+	const uint64_t b = 1 + (((uint64_t)errorRate * (uint32_t)(timestamp - lastTimestamp)) >> (12 - OT_ESTIMATOR_BOUND_SHIFT));
+	bound = b > OT_ESTIMATOR_MAX_BOUND ? OT_ESTIMATOR_MAX_BOUND : (uint16_t)b;
+	return (uint16_t)(int16_t)predict(timestamp);
+}
+
+bool OpenThermEstimator::needsPoll(unsigned long timestamp, uint16_t tolerance) const
+{
+	uint16_t bound;
+	estimate(timestamp, bound);
+	return bound > tolerance;
+}
+
+} // namespace OT
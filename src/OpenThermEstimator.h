@@ -0,0 +1,41 @@
+/*
+OpenThermEstimator.h - Predicts slowly changing OpenTherm values between polls
+Licensed under MIT license
+
+Fixed point alpha-beta (level + trend) model of one f8.8 or s16 data value.
+Besides the prediction it tracks how far polls typically land from it per
+millisecond of extrapolation; twice that, times the time since the last
+poll, is the confidence bound. Callers poll only when the bound exceeds
+their tolerance, and call invalidate() when a known input (TSet, flame,
+modulation) changes so the next read goes to the bus.
+*/
+
+#ifndef OpenThermEstimator_h
+#define OpenThermEstimator_h
+
+#include <stdint.h>
+#include <Arduino.h>
+
+namespace OT {
+
+class OpenThermEstimator
+{
+private:
+	byte samples; // since the last invalidate(), saturating
+	unsigned long lastTimestamp;
+	int32_t level; // value units (1/256 for f8.8)
+	int32_t trend; // value units per ms, Q12
+	uint32_t errorRate; // mean |prediction error| per ms of extrapolation, Q12
+
+	int32_t predict(unsigned long timestamp) const;
+public:
+	OpenThermEstimator();
+	void update(unsigned long timestamp, uint16_t value);
+	uint16_t estimate(unsigned long timestamp, uint16_t &bound) const;
+	bool needsPoll(unsigned long timestamp, uint16_t tolerance) const;
+	void invalidate();
+};
+
+} // namespace OT
+
+#endif // OpenThermEstimator_h
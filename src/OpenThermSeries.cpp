@@ -0,0 +1,162 @@
+/*
+OpenThermSeries.cpp - Compressed time series of OpenTherm data values
+Licensed under MIT license
+*/
+
+#include "OpenThermSeries.h"
+namespace OT {
+
+// worst case sample: 4 + 32 timestamp bits and 3 + 16 value bits
+static const uint8_t OT_SERIES_MAX_SAMPLE_BITS = 55;
+
+static uint16_t zigZag(int16_t v)
+{
+	return (uint16_t)((v << 1) ^ (v >> 15));
+}
+
+static int16_t unZigZag(uint16_t v)
+{
+	return (int16_t)((v >> 1) ^ -(int16_t)(v & 1));
+}
+
+OpenThermSeries::OpenThermSeries(uint8_t *buffer, size_t size):
+	buffer(buffer),
+	size(size)
+{
+	clear();
+}
+
+void OpenThermSeries::clear()
+{
+	bitLength = 0;
+	count = 0;
+	lastTimestamp = 0;
+	lastDelta = 0;
+	lastValue = 0;
+}
+
+void OpenThermSeries::writeBits(uint32_t bits, uint8_t length)
+{
+	while (length > 0) {
+		length--;
+		uint8_t &b = buffer[bitLength >> 3];
+		uint8_t mask = 0x80 >> (bitLength & 7);
+		if ((bits >> length) & 1) b |= mask; else b &= ~mask;
+		bitLength++;
+	}
+}
+
+bool OpenThermSeries::append(unsigned long timestamp, uint16_t value)
+{
+	if (bitLength + OT_SERIES_MAX_SAMPLE_BITS > (unsigned long)size * 8) return false;
+
+	const uint32_t ts = timestamp;
+	if (count == 0) {
+		writeBits(ts, 32);
+		writeBits(value, 16);
+	}
+	else {
+		const uint32_t delta = ts - lastTimestamp;
+		const int32_t dod = (int32_t)(delta - lastDelta);
+		if (dod == 0) writeBits(0, 1);
+		else if (dod >= -64 && dod < 64) { writeBits(B10, 2); writeBits(dod, 7); }
+		else if (dod >= -2048 && dod < 2048) { writeBits(B110, 3); writeBits(dod, 12); }
+		else if (dod >= -524288L && dod < 524288L) { writeBits(B1110, 4); writeBits(dod, 20); }
+		else { writeBits(B1111, 4); writeBits(dod, 32); }
+		lastDelta = delta;
+
+		const uint16_t zz = zigZag((int16_t)(value - lastValue));
+		if (zz == 0) writeBits(0, 1);
+		else if (zz < 16) { writeBits(B10, 2); writeBits(zz, 4); }
+		else if (zz < 256) { writeBits(B110, 3); writeBits(zz, 8); }
+		else { writeBits(B111, 3); writeBits(zz, 16); }
+	}
+	lastTimestamp = ts;
+	lastValue = value;
+	count++;
+	return true;
+}
+
+unsigned int OpenThermSeries::getCount() const
+{
+	return count;
+}
+
+size_t OpenThermSeries::getSize() const
+{
+	return (bitLength + 7) >> 3;
+}
+
+const uint8_t *OpenThermSeries::getBuffer() const
+{
+	return buffer;
+}
+
+OpenThermSeriesReader::OpenThermSeriesReader(const OpenThermSeries &series):
+	OpenThermSeriesReader(series.getBuffer(), series.getCount())
+{
+}
+
+OpenThermSeriesReader::OpenThermSeriesReader(const uint8_t *buffer, unsigned int count):
+	buffer(buffer),
+	count(count),
+	index(0),
+	bitPosition(0),
+	lastTimestamp(0),
+	lastDelta(0),
+	lastValue(0)
+{
+}
+
+uint32_t OpenThermSeriesReader::readBits(uint8_t length)
+{
+	uint32_t bits = 0;
+	while (length > 0) {
+		length--;
+		bits = (bits << 1) | ((buffer[bitPosition >> 3] >> (7 - (bitPosition & 7))) & 1);
+		bitPosition++;
+	}
+	return bits;
+}
+
+int32_t OpenThermSeriesReader::readSigned(uint8_t length)
+{
+	uint32_t bits = readBits(length);
+	if (length < 32 && (bits & (1ul << (length - 1)))) bits |= ~0ul << length;
+	return (int32_t)bits;
+}
+
+bool OpenThermSeriesReader::next(unsigned long &timestamp, uint16_t &value)
+{
+	if (index >= count) return false;
+
+	if (index == 0) {
+		lastTimestamp = readBits(32);
+		lastValue = readBits(16);
+	}
+	else {
+		int32_t dod = 0;
+		if (readBits(1)) {
+			if (!readBits(1)) dod = readSigned(7);
+			else if (!readBits(1)) dod = readSigned(12);
+			else if (!readBits(1)) dod = readSigned(20);
+			else dod = readSigned(32);
+		}
+		lastDelta += dod;
+		lastTimestamp += lastDelta;
+
+		uint16_t zz = 0;
+		if (readBits(1)) {
+			if (!readBits(1)) zz = readBits(4);
+			else if (!readBits(1)) zz = readBits(8);
+			else zz = readBits(16);
+		}
+		lastValue += unZigZag(zz);
+	}
+	index++;
+	timestamp = lastTimestamp;
+	value = lastValue;
+	return true;
+}
+
+} // namespace OT
@@ -0,0 +1,63 @@
+/*
+OpenThermSeries.h - Compressed time series of OpenTherm data values
+Licensed under MIT license
+
+Stores (timestamp, 16-bit data value) samples of one data ID in a caller
+supplied buffer, bit packed:
+- timestamps as delta-of-delta: '0' | '10'+7 | '110'+12 | '1110'+20 | '1111'+32 bits
+- values as zig-zag delta:      '0' | '10'+4 | '110'+8 | '111'+16 bits
+A sample polled at a fixed period with an unchanged value costs 2 bits.
+*/
+
+#ifndef OpenThermSeries_h
+#define OpenThermSeries_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <Arduino.h>
+
+namespace OT {
+
+class OpenThermSeries
+{
+private:
+	uint8_t *buffer;
+	const size_t size;
+	unsigned long bitLength;
+	unsigned int count;
+	uint32_t lastTimestamp;
+	uint32_t lastDelta;
+	uint16_t lastValue;
+
+	void writeBits(uint32_t bits, uint8_t length);
+public:
+	OpenThermSeries(uint8_t *buffer, size_t size);
+	bool append(unsigned long timestamp, uint16_t value);
+	void clear();
+	unsigned int getCount() const;
+	size_t getSize() const;
+	const uint8_t *getBuffer() const;
+};
+
+class OpenThermSeriesReader
+{
+private:
+	const uint8_t *buffer;
+	const unsigned int count;
+	unsigned int index;
+	unsigned long bitPosition;
+	uint32_t lastTimestamp;
+	uint32_t lastDelta;
+	uint16_t lastValue;
+
+	uint32_t readBits(uint8_t length);
+	int32_t readSigned(uint8_t length);
+public:
+	OpenThermSeriesReader(const OpenThermSeries &series);
+	OpenThermSeriesReader(const uint8_t *buffer, unsigned int count);
+	bool next(unsigned long &timestamp, uint16_t &value);
+};
+
+} // namespace OT
+
+#endif // OpenThermSeries_h
@@ -0,0 +1,125 @@
+/*
+OpenThermTelemetry.cpp - Binary stream of OpenTherm transactions over a serial port
+Licensed under MIT license
+*/
+
+#include "OpenThermTelemetry.h"
+namespace OT {
+
+static void putUInt32(byte *buf, uint32_t value)
+{
+	for (byte i = 0; i < 4; i++) {
+		buf[i] = value & 0xFF;
+		value >>= 8;
+	}
+}
+
+static uint32_t getUInt32(const byte *buf)
+{
+	uint32_t value = 0;
+	for (byte i = 4; i > 0; i--) {
+		value = (value << 8) | buf[i - 1];
+	}
+	return value;
+}
+
+OpenThermTelemetry::OpenThermTelemetry(Print &port, bool unbuffered):
+	port(port),
+	unbuffered(unbuffered),
+	droppedCount(0)
+{
+}
+
+bool OpenThermTelemetry::hasRoom()
+{
+	return unbuffered || port.availableForWrite() >= FRAME_SIZE;
+}
+
+byte OpenThermTelemetry::encode(const OpenThermTraceRecord &record, byte *frame)
+{
+	byte data[RECORD_SIZE];
+	putUInt32(data, record.timestamp);
+	putUInt32(data + 4, record.request);
+	putUInt32(data + 8, record.response);
+	data[12] = record.status;
+	byte sum = 0;
+	for (byte i = 0; i < RECORD_SIZE - 1; i++) sum += data[i];
+	data[RECORD_SIZE - 1] = -sum;
+
+	// COBS: each zero is replaced by the distance to the next one
+	byte code = 0;
+	byte length = 1;
+	for (byte i = 0; i < RECORD_SIZE; i++) {
+		if (data[i] == 0) {
+			frame[code] = length - code;
+			code = length++;
+		}
+		else {
+			frame[length++] = data[i];
+		}
+	}
+	frame[code] = length - code;
+	frame[length++] = 0;
+	return length;
+}
+
+bool OpenThermTelemetry::decode(const byte *frame, size_t length, OpenThermTraceRecord &record)
+{
+	byte data[RECORD_SIZE];
+	byte count = 0;
+	size_t i = 0;
+	while (i < length) {
+		const byte code = frame[i++];
+		if (code == 0 || i + code - 1 > length) return false;
+		for (byte j = 1; j < code; j++) {
+			if (count == RECORD_SIZE) return false;
+			data[count++] = frame[i++];
+		}
+		if (i < length) {
+			if (count == RECORD_SIZE) return false;
+			data[count++] = 0;
+		}
+	}
+	if (count != RECORD_SIZE) return false;
+
+	byte sum = 0;
+	for (byte j = 0; j < RECORD_SIZE; j++) sum += data[j];
+	if (sum != 0 || data[12] > OpenThermResponseStatus::TIMEOUT) return false;
+
+	record.timestamp = getUInt32(data);
+	record.request = getUInt32(data + 4);
+	record.response = getUInt32(data + 8);
+	record.status = (OpenThermResponseStatus)data[12];
+	return true;
+}
+
+bool OpenThermTelemetry::write(const OpenThermTraceRecord &record)
+{
+	if (!hasRoom()) {
+		droppedCount++;
+		return false;
+	}
+	byte frame[FRAME_SIZE];
+	port.write(frame, encode(record, frame));
+	return true;
+}
+
+uint16_t OpenThermTelemetry::write(OpenThermTrace &trace, OpenThermTraceCursor &cursor)
+{
+	uint16_t written = 0;
+	OpenThermTraceRecord record;
+	// records stay in the trace until there is room, the trace drops the oldest
+	while (hasRoom() && trace.read(cursor, record)) {
+		byte frame[FRAME_SIZE];
+		port.write(frame, encode(record, frame));
+		written++;
+	}
+	return written;
+}
+
+unsigned int OpenThermTelemetry::getDroppedCount() const
+{
+	return droppedCount;
+}
+
+} // namespace OT
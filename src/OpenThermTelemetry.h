@@ -0,0 +1,49 @@
+/*
+OpenThermTelemetry.h - Binary stream of OpenTherm transactions over a serial port
+Licensed under MIT license
+
+Each transaction is sent as one COBS frame terminated by a zero byte:
+timestamp, request and response (little endian uint32), status and an
+8 bit checksum, 16 bytes on the wire. A frame is only written when the
+port's TX buffer can take all of it, so writing never blocks; frames that
+do not fit are dropped and counted. This needs a port that implements
+availableForWrite() (HardwareSerial does). Print returns 0 by default, so
+on other ports (SoftwareSerial, most displays and files) every frame would
+be dropped; pass unbuffered = true to write unconditionally instead.
+decode() turns a received frame back into a record and also builds on the
+host.
+*/
+
+#ifndef OpenThermTelemetry_h
+#define OpenThermTelemetry_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <Arduino.h>
+#include "OpenThermTrace.h"
+
+namespace OT {
+
+class OpenThermTelemetry
+{
+private:
+	Print &port;
+	const bool unbuffered;
+	unsigned int droppedCount;
+
+	bool hasRoom();
+public:
+	static const byte RECORD_SIZE = 14; // payload incl. checksum
+	static const byte FRAME_SIZE = RECORD_SIZE + 2; // COBS overhead and delimiter
+
+	OpenThermTelemetry(Print &port, bool unbuffered = false); // unbuffered: port has no availableForWrite(), writes may block
+	bool write(const OpenThermTraceRecord &record); // false if the TX buffer is too full
+	uint16_t write(OpenThermTrace &trace, OpenThermTraceCursor &cursor); // sends what fits, returns frames written
+	unsigned int getDroppedCount() const;
+	static byte encode(const OpenThermTraceRecord &record, byte *frame); // FRAME_SIZE bytes, returns length
+	static bool decode(const byte *frame, size_t length, OpenThermTraceRecord &record); // frame without the zero delimiter
+};
+
+} // namespace OT
+
+#endif // OpenThermTelemetry_h
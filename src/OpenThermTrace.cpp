@@ -0,0 +1,73 @@
+/*
+OpenThermTrace.cpp - Ring of completed OpenTherm transactions for live readers
+Licensed under MIT license
+*/
+
+#include "OpenThermTrace.h"
+namespace OT {
+
+OpenThermTrace::OpenThermTrace(OpenThermTraceRecord *records, uint16_t size):
+	records(records),
+	size(size),
+	head(0)
+{
+}
+
+void OpenThermTrace::push(unsigned long timestamp, unsigned long request, unsigned long response, OpenThermResponseStatus status)
+{
+	OpenThermTraceRecord &record = records[head % size];
+	record.timestamp = timestamp;
+	record.request = request;
+	record.response = response;
+	record.status = status;
+	head = head + 1;
+}
+
+uint32_t OpenThermTrace::getHead() const
+{
+	return head;
+}
+
+void OpenThermTrace::attach(OpenThermTraceCursor &cursor) const
+{
+	cursor.position = head;
+	cursor.lost = 0;
+}
+
+bool OpenThermTrace::read(OpenThermTraceCursor &cursor, OpenThermTraceRecord &record) const
+{
+	if (cursor.position == head) return false;
+	if (head - cursor.position > size) {
+		cursor.lost += head - cursor.position - size;
+		cursor.position = head - size;
+	}
+	record = records[cursor.position % size];
+	cursor.position++;
+	return true;
+}
+
+// Copies up to count records at once, so a logger can hand whole blocks to
+// a slow sink (SD card, flash, file) in one write.
+uint16_t OpenThermTrace::read(OpenThermTraceCursor &cursor, OpenThermTraceRecord *records, uint16_t count) const
+{
+	if (head - cursor.position > size) {
+		cursor.lost += head - cursor.position - size;
+		cursor.position = head - size;
+	}
+	const uint16_t copied = head - cursor.position < count ? head - cursor.position : count;
+	uint16_t index = cursor.position % size;
+	for (uint16_t i = 0; i < copied; i++) {
+		records[i] = this->records[index];
+		if (++index == size) index = 0;
+	}
+	cursor.position += copied;
+	return copied;
+}
+
+uint16_t OpenThermTrace::available(const OpenThermTraceCursor &cursor) const
+{
+	const uint32_t count = head - cursor.position;
+	return count > size ? size : count;
+}
+
+} // namespace OT
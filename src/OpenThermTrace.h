@@ -0,0 +1,54 @@
+/*
+OpenThermTrace.h - Ring of completed OpenTherm transactions for live readers
+Licensed under MIT license
+
+One writer, see OpenTherm::setTrace(), and any number of readers. Records
+are written once into caller supplied storage, oldest overwritten first;
+each reader only keeps a cursor, so the writer cost does not depend on the
+number of readers and a slow reader never holds up the bus. A reader that
+falls more than size records behind skips ahead and counts what it lost.
+Writer and readers must run in the same context (the sketch loop or one
+host thread), so a record is never read while it is being written; size
+must be at least 1.
+*/
+
+#ifndef OpenThermTrace_h
+#define OpenThermTrace_h
+
+#include <stdint.h>
+#include <Arduino.h>
+#include "OpenTherm.h"
+
+namespace OT {
+
+struct OpenThermTraceRecord {
+	unsigned long timestamp; // millis() at completion
+	unsigned long request;
+	unsigned long response;
+	OpenThermResponseStatus status;
+};
+
+struct OpenThermTraceCursor {
+	uint32_t position;
+	uint32_t lost; // records overwritten before this reader got to them
+};
+
+class OpenThermTrace
+{
+private:
+	OpenThermTraceRecord *records;
+	const uint16_t size;
+	volatile uint32_t head; // records written so far
+public:
+	OpenThermTrace(OpenThermTraceRecord *records, uint16_t size); // size >= 1
+	void push(unsigned long timestamp, unsigned long request, unsigned long response, OpenThermResponseStatus status);
+	uint32_t getHead() const;
+	void attach(OpenThermTraceCursor &cursor) const; // start reading at the next record
+	bool read(OpenThermTraceCursor &cursor, OpenThermTraceRecord &record) const;
+	uint16_t read(OpenThermTraceCursor &cursor, OpenThermTraceRecord *records, uint16_t count) const; // returns number of records copied
+	uint16_t available(const OpenThermTraceCursor &cursor) const;
+};
+
+} // namespace OT
+
+#endif // OpenThermTrace_h
@@ -0,0 +1,81 @@
+/*
+OpenThermTraceMerge.cpp - Merges the traces of several OpenTherm buses by time
+Licensed under MIT license
+*/
+
+#include "OpenThermTraceMerge.h"
+namespace OT {
+
+OpenThermTraceMerge::OpenThermTraceMerge(OpenThermMergeChannel *channels, byte count, unsigned long maxDelay):
+	channels(channels),
+	count(count),
+	maxDelay(maxDelay),
+	heapSize(0)
+{
+	for (byte i = 0; i < count; i++) {
+		channels[i].trace->attach(channels[i].cursor);
+		channels[i].pending = false;
+	}
+}
+
+// timestamps wrap with millis()
+bool OpenThermTraceMerge::isBefore(byte a, byte b) const
+{
+	return (long)(channels[a].next.timestamp - channels[b].next.timestamp) < 0;
+}
+
+void OpenThermTraceMerge::push(byte channel)
+{
+	channels[channel].pending = true;
+	byte i = heapSize++;
+	while (i > 0) {
+		const byte parent = (i - 1) / 2;
+		if (!isBefore(channel, channels[parent].heap)) break;
+		channels[i].heap = channels[parent].heap;
+		i = parent;
+	}
+	channels[i].heap = channel;
+}
+
+void OpenThermTraceMerge::pop()
+{
+	channels[channels[0].heap].pending = false;
+	const byte last = channels[--heapSize].heap;
+	byte i = 0;
+	for (;;) {
+		byte child = 2 * i + 1;
+		if (child >= heapSize) break;
+		if (child + 1 < heapSize && isBefore(channels[child + 1].heap, channels[child].heap)) child++;
+		if (!isBefore(channels[child].heap, last)) break;
+		channels[i].heap = channels[child].heap;
+		i = child;
+	}
+	if (heapSize > 0) channels[i].heap = last;
+}
+
+bool OpenThermTraceMerge::read(OpenThermTraceRecord &record, byte &channel, unsigned long now)
+{
+	for (byte i = 0; i < count && heapSize < count; i++) {
+		OpenThermMergeChannel &ch = channels[i];
+		if (!ch.pending && ch.trace->read(ch.cursor, ch.next)) push(i);
+	}
+	if (heapSize == 0) return false;
+
+	channel = channels[0].heap;
+	// a channel without a record could still deliver an older one
+	if (heapSize < count && (long)(now - channels[channel].next.timestamp) < (long)maxDelay) return false;
+	record = channels[channel].next;
+	pop();
+	return true;
+}
+
+uint32_t OpenThermTraceMerge::getLostCount() const
+{
+	uint32_t lost = 0;
+	for (byte i = 0; i < count; i++) {
+		lost += channels[i].cursor.lost;
+	}
+	return lost;
+}
+
+} // namespace OT
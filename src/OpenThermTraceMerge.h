@@ -0,0 +1,51 @@
+/*
+OpenThermTraceMerge.h - Merges the traces of several OpenTherm buses by time
+Licensed under MIT license
+
+Every channel keeps its own OpenThermTrace, written only by its bus. The
+merge reads each trace through its own cursor, holds the oldest unmerged
+record per channel in a min-heap on timestamp and returns records in time
+order. While every channel has a record waiting the order is exact; an
+idle channel holds the others back for at most maxDelay milliseconds.
+Like OpenThermTrace itself this is single context: every bus's process()
+and the merge must run in the same loop or thread. Buses driven from
+separate threads need their own locking around push() and read().
+*/
+
+#ifndef OpenThermTraceMerge_h
+#define OpenThermTraceMerge_h
+
+#include <stdint.h>
+#include <Arduino.h>
+#include "OpenThermTrace.h"
+
+namespace OT {
+
+struct OpenThermMergeChannel {
+	OpenThermTrace *trace; // set by the caller
+	OpenThermTraceCursor cursor;
+	OpenThermTraceRecord next; // oldest unmerged record when pending
+	bool pending;
+	byte heap; // heap slot with this index holds a channel index
+};
+
+class OpenThermTraceMerge
+{
+private:
+	OpenThermMergeChannel *channels;
+	const byte count;
+	const unsigned long maxDelay;
+	byte heapSize;
+
+	bool isBefore(byte a, byte b) const;
+	void push(byte channel);
+	void pop();
+public:
+	OpenThermTraceMerge(OpenThermMergeChannel *channels, byte count, unsigned long maxDelay);
+	bool read(OpenThermTraceRecord &record, byte &channel, unsigned long now); // now is millis()
+	uint32_t getLostCount() const;
+};
+
+} // namespace OT
+
+#endif // OpenThermTraceMerge_h